@@ -0,0 +1,314 @@
+#include "annealing.hpp"
+#include "area_book.hpp"
+#include "cgshop2023_core/hilbert_order.hpp"
+#include "cgshop2023_core/lower_bound.hpp"
+#include "cgshop2023_core/profiling.hpp"
+#include "coverage.hpp"
+#include "globals.hpp"
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <random>
+#include <utility>
+
+// Energy minimized by the driver: the number of polygons, minus a bonus for
+// concentrating area in few large polygons (which leaves small polygons that
+// are easy to remove). The bonus stays below 1 so no amount of rebalancing
+// outweighs a removal.
+class AnnealEnergy {
+public:
+	AnnealEnergy(const Instance& inst, const Solution& sol, double area_weight)
+			: m_weight(area_weight), m_book(sol.polygons()) {
+		m_total_area = CGAL::to_double(inst.area());
+		for (size_t i = 0; i < m_book.size(); ++i)
+			m_areas.push_back(relative_area(i));
+		for (double a : m_areas)
+			m_sum_sq += a * a;
+	}
+
+	[[nodiscard]] double value() const {
+		return double(m_areas.size()) - m_weight * min(m_sum_sq, 1.0);
+	}
+
+	void update(size_t i, const SimplePolygon& poly) {
+		m_sum_sq -= m_areas[i] * m_areas[i];
+		m_book.update(i, poly);
+		m_areas[i] = relative_area(i);
+		m_sum_sq += m_areas[i] * m_areas[i];
+	}
+
+	void push_back(const SimplePolygon& poly) {
+		m_book.push_back(poly);
+		m_areas.push_back(relative_area(m_areas.size()));
+		m_sum_sq += m_areas.back() * m_areas.back();
+	}
+
+	// mirrors remove_polygon
+	void swap_remove(size_t i) {
+		m_sum_sq -= m_areas[i] * m_areas[i];
+		m_book.swap_remove(i);
+		swap(m_areas[i], m_areas.back());
+		m_areas.pop_back();
+	}
+
+	[[nodiscard]] size_t size() const { return m_areas.size(); }
+
+	// total polygon area relative to the instance (1 means no overlap)
+	[[nodiscard]] double overlap() const {
+		return CGAL::to_double(m_book.total()) / m_total_area;
+	}
+
+private:
+	double relative_area(size_t i) const {
+		return CGAL::to_double(m_book.area(i)) / m_total_area;
+	}
+
+	double m_weight;
+	AreaBook m_book;
+	double m_total_area;
+	double m_sum_sq = 0;
+	vector<double> m_areas;
+};
+
+// Two convex polygons whose union is poly: the two sides of a random diagonal,
+// or for a triangle the halves cut off by the line from a vertex to the
+// midpoint of the opposite side. None if that midpoint cannot be written out.
+static optional<pair<SimplePolygon, SimplePolygon>>
+split_polygon(const SimplePolygon& poly) {
+	size_t n = poly.size();
+	if (n < 3)
+		return nullopt;
+	size_t a = std::uniform_int_distribution<size_t>(0, n - 1)(g);
+	auto at = [&](size_t k) { return poly.vertex((a + k) % n); };
+	SimplePolygon first, second;
+	if (n == 3) {
+		Point mid = CGAL::midpoint(at(1), at(2));
+		if (!fits_solution_format(mid))
+			return nullopt;
+		first.push_back(at(0));
+		first.push_back(at(1));
+		first.push_back(mid);
+		second.push_back(at(0));
+		second.push_back(mid);
+		second.push_back(at(2));
+		return make_pair(first, second);
+	}
+	// diagonal from a to a + d, leaving at least a triangle on either side
+	size_t d = std::uniform_int_distribution<size_t>(2, n - 2)(g);
+	for (size_t k = 0; k <= d; ++k)
+		first.push_back(at(k));
+	for (size_t k = d; k <= n; ++k)
+		second.push_back(at(k));
+	return make_pair(first, second);
+}
+
+void anneal(Instance& inst, Solution& sol, const AnnealConfig& config) {
+	using clock = std::chrono::steady_clock;
+	auto start = clock::now();
+	auto elapsed = [&]() {
+		return std::chrono::duration<double>(clock::now() - start).count();
+	};
+	if (config.iterations == 0 && config.time_limit <= 0) {
+		cerr << "anneal: no iteration or time limit given, skipping" << endl;
+		return;
+	}
+
+	cerr << "Running anneal on " << sol.polygons().size() << " polygons\n";
+	sort_by_hilbert(sol.polygons_m());
+	CoverageIndex index(inst, sol.polygons());
+	AnnealEnergy energy(inst, sol, config.area_weight);
+	// smallest cover seen
+	vector<SimplePolygon> best = sol.polygons();
+	vector<double> history(max<size_t>(config.history_length, 1),
+												 energy.value());
+	std::uniform_real_distribution<double> unit(0, 1);
+	size_t accepted = 0, removed = 0, splits = 0;
+
+	auto progress = [&](size_t iter) {
+		double p = 0;
+		if (config.iterations > 0)
+			p = max(p, double(iter) / config.iterations);
+		if (config.time_limit > 0)
+			p = max(p, elapsed() / config.time_limit);
+		return min(p, 1.0);
+	};
+	auto temperature = [&](double p) {
+		if (config.schedule == CoolingSchedule::Linear)
+			return config.start_temperature +
+						 (config.end_temperature - config.start_temperature) * p;
+		return config.start_temperature *
+					 pow(config.end_temperature / config.start_temperature, p);
+	};
+	// late acceptance compares against the energy of the evaluation
+	// history_length evaluations ago, not counting moves that never got to one
+	size_t evaluations = 0;
+	auto accept = [&](size_t iter, double current, double next) {
+		if (config.history_length > 0) {
+			double& slot = history[evaluations++ % history.size()];
+			bool ok = next <= current || next <= slot;
+			slot = ok ? next : current;
+			return ok;
+		}
+		if (next <= current)
+			return true;
+		double t = temperature(progress(iter));
+		return t > 0 && unit(g) < exp((current - next) / t);
+	};
+	auto pick = [&](size_t n) {
+		return std::uniform_int_distribution<size_t>(0, n - 1)(g);
+	};
+	// Removals and splits leave a polygon out of the Hilbert order each; once
+	// they add up to 1/RESORT_SHARE of the cover, sort again and rebuild what is
+	// indexed by position (linear, so constant per move amortized).
+	constexpr size_t RESORT_SHARE = 8;
+	size_t displaced = 0;
+	auto displace = [&]() {
+		if (++displaced * RESORT_SHARE < sol.polygons().size())
+			return;
+		sort_by_hilbert(sol.polygons_m());
+		index = CoverageIndex(inst, sol.polygons());
+		energy = AnnealEnergy(inst, sol, config.area_weight);
+		displaced = 0;
+	};
+
+	// no point in searching on once the cover reaches the lower bound
+	size_t bound = cover_lower_bound(inst);
+	size_t iter = 0;
+	for (; (config.iterations == 0 || iter < config.iterations) &&
+				 (config.time_limit <= 0 || elapsed() < config.time_limit) &&
+				 sol.polygons().size() > bound;
+			 ++iter) {
+		double current = energy.value();
+		size_t move = unit(g) < config.split_probability ? 3 : pick(3);
+		size_t i = pick(sol.polygons().size());
+
+		if (move == 3) {
+			// split
+			auto pieces = split_polygon(sol.polygons()[i]);
+			if (!pieces)
+				continue;
+			SimplePolygon old = sol.polygons()[i];
+			energy.update(i, pieces->first);
+			energy.push_back(pieces->second);
+			if (accept(iter, current, energy.value())) {
+				sol.polygons_m()[i] = pieces->first;
+				index.update(i, pieces->first);
+				sol.polygons_m().push_back(pieces->second);
+				index.push_back(pieces->second);
+				++accepted;
+				++splits;
+				displace();
+			} else {
+				energy.swap_remove(energy.size() - 1);
+				energy.update(i, old);
+			}
+			continue;
+		}
+
+		if (move == 0) {
+			// remove
+			size_t cur_size = sol.polygons().size();
+			if (try_removal(inst, sol, i, true, config.replacement_choices,
+											&index) ||
+					(MULTI_ABSORB && try_multi_removal(inst, sol, i, index))) {
+				for (size_t j : index.overlapping(i))
+					energy.update(j, sol.polygons()[j]);
+				energy.swap_remove(i);
+				remove_polygon(sol, i, &index);
+				++removed;
+				++accepted;
+				if (sol.polygons().size() < best.size())
+					best = sol.polygons();
+				displace();
+			}
+			if (VERBOSE && sol.polygons().size() < cur_size) {
+				cerr << "anneal iteration " << iter << ": removed polygon, now "
+						 << sol.polygons().size() << endl;
+			}
+			continue;
+		}
+
+		if (move == 1) {
+			// shrink
+			bool redundant = false;
+			SimplePolygon old = sol.polygons()[i];
+			SimplePolygon newPoly =
+					minimize_to_necessary(sol.polygons(), index, i, redundant);
+			if (redundant) {
+				energy.swap_remove(i);
+				remove_polygon(sol, i, &index);
+				++removed;
+				++accepted;
+				if (sol.polygons().size() < best.size())
+					best = sol.polygons();
+				displace();
+				continue;
+			}
+			energy.update(i, newPoly);
+			if (accept(iter, current, energy.value())) {
+				sol.polygons_m()[i] = newPoly;
+				index.update(i, newPoly);
+				++accepted;
+			} else {
+				energy.update(i, old);
+			}
+			continue;
+		}
+
+		// expand i towards part of an overlapping polygon j, then shrink j
+		auto neighbours = index.overlapping(i);
+		if (neighbours.empty())
+			continue;
+		size_t j = neighbours[pick(neighbours.size())];
+		vector<Point> desired(sol.polygons()[j].begin(), sol.polygons()[j].end());
+		shuffle(desired.begin(), desired.end(), g);
+		desired.resize(1 + pick(desired.size()));
+		bool allCovered = false;
+		SimplePolygon expanded =
+				greedy_expand(inst, sol.polygons()[i], desired, allCovered);
+		if (!allCovered)
+			continue;
+		SimplePolygon old_i = sol.polygons()[i];
+		SimplePolygon old_j = sol.polygons()[j];
+		sol.polygons_m()[i] = expanded;
+		index.update(i, expanded);
+		energy.update(i, expanded);
+		bool redundant = false;
+		SimplePolygon shrunk =
+				minimize_to_necessary(sol.polygons(), index, j, redundant);
+		if (redundant) {
+			energy.swap_remove(j);
+			remove_polygon(sol, j, &index);
+			++removed;
+			++accepted;
+			if (sol.polygons().size() < best.size())
+				best = sol.polygons();
+			displace();
+			continue;
+		}
+		energy.update(j, shrunk);
+		if (accept(iter, current, energy.value())) {
+			sol.polygons_m()[j] = shrunk;
+			index.update(j, shrunk);
+			++accepted;
+		} else {
+			sol.polygons_m()[i] = old_i;
+			index.update(i, old_i);
+			energy.update(i, old_i);
+			energy.update(j, old_j);
+		}
+	}
+
+	profiling::count("anneal.moves", iter);
+	profiling::count("anneal.accepted", accepted);
+	profiling::count("anneal.removals", removed);
+	profiling::count("anneal.splits", splits);
+	if (VERBOSE)
+		cerr << "anneal: overlap factor of the last cover " << energy.overlap()
+				 << endl;
+	sol.polygons_m() = std::move(best);
+	cerr << "Finished anneal after " << iter << " moves (" << accepted
+			 << " accepted, " << removed << " removals, " << splits
+			 << " splits) in " << elapsed()
+			 << "s, now have " << sol.polygons().size() << " polygons\n";
+}
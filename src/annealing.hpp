@@ -0,0 +1,42 @@
+#pragma once
+
+#include "cgshop2023_core/cpp_instance.hpp"
+#include "localsearch.hpp"
+
+using namespace cgshop2023;
+using namespace std;
+
+enum class CoolingSchedule { Geometric, Linear };
+
+struct AnnealConfig {
+	// stop after this many moves (0 = no limit)
+	size_t iterations = 0;
+	// stop after this many seconds (0 = no limit)
+	double time_limit = 0;
+	// late acceptance hill climbing with a history of this length instead of
+	// simulated annealing (0 = use simulated annealing)
+	size_t history_length = 0;
+	// a split raises the energy by about 1, so it is only accepted with
+	// probability around exp(-1 / temperature)
+	double start_temperature = 0.5;
+	double end_temperature = 1e-4;
+	CoolingSchedule schedule = CoolingSchedule::Geometric;
+	// weight of the sum of squared (relative) polygon areas in the energy
+	double area_weight = 0.5;
+	size_t replacement_choices = 16;
+	// share of the moves that are splits
+	double split_probability = 0.1;
+};
+
+// Metaheuristic driver around the greedy moves:
+//  - remove: try_removal of a random polygon (always accepted)
+//  - shrink: minimize_to_necessary of a random polygon
+//  - expand: greedy_expand a random polygon towards some of the vertices of
+//    an overlapping one, then shrink that one to what it still has to cover
+//  - split: cut a random polygon along a diagonal into two convex pieces
+// Shrinks, expansions and splits are accepted according to simulated
+// annealing or late acceptance. Splits add a polygon, so the cover can
+// temporarily grow to escape the local optima of try_remove_all; the pieces
+// are then free to expand and shrink apart. The search runs entirely in
+// memory; sol is replaced by the smallest cover seen.
+void anneal(Instance& inst, Solution& sol, const AnnealConfig& config);
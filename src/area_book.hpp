@@ -0,0 +1,56 @@
+#pragma once
+
+#include "cgshop2023_core/cpp_instance.hpp"
+#include <vector>
+
+using namespace cgshop2023;
+using namespace std;
+
+// Exact (unsigned) areas of the polygons of a cover, kept in sync with it like
+// the coverage index, so every polygon's area is computed once per change and
+// the exact total is maintained incrementally instead of being summed again.
+class AreaBook {
+public:
+	explicit AreaBook(const vector<SimplePolygon>& polys) {
+		for (const auto& poly : polys) {
+			m_areas.push_back(CGAL::abs(poly.area()));
+			m_total += m_areas.back();
+		}
+		flatten();
+	}
+
+	[[nodiscard]] size_t size() const { return m_areas.size(); }
+	[[nodiscard]] const Kernel::FT& area(size_t i) const { return m_areas[i]; }
+	[[nodiscard]] const Kernel::FT& total() const { return m_total; }
+
+	// polygon i of the cover has been replaced by poly
+	void update(size_t i, const SimplePolygon& poly) {
+		Kernel::FT next = CGAL::abs(poly.area());
+		m_total += next - m_areas[i];
+		m_areas[i] = next;
+		flatten();
+	}
+
+	// poly has been appended to the cover
+	void push_back(const SimplePolygon& poly) {
+		m_areas.push_back(CGAL::abs(poly.area()));
+		m_total += m_areas.back();
+		flatten();
+	}
+
+	// mirrors remove_polygon
+	void swap_remove(size_t i) {
+		m_total -= m_areas[i];
+		swap(m_areas[i], m_areas.back());
+		m_areas.pop_back();
+		flatten();
+	}
+
+private:
+	// Evaluating the lazy total replaces its expression tree by the exact
+	// value; otherwise every update would add a node to it.
+	void flatten() { CGAL::exact(m_total); }
+
+	vector<Kernel::FT> m_areas;
+	Kernel::FT m_total = 0;
+};
@@ -0,0 +1,244 @@
+#include <bits/stdc++.h>
+
+#include "cgshop2023_core/cpp_instance.hpp"
+#include "cgshop2023_core/profiling.hpp"
+#include "cgshop2023_core/verify.hpp"
+#include "globals.hpp"
+#include "localsearch.hpp"
+#include "triangulation.hpp"
+
+using namespace cgshop2023;
+using namespace std;
+
+// Microbenchmarks of the geometric hot paths on the fixed instance subset in
+// bench_instance_list.txt. Every benchmark is repeated and reported as
+// min/median/p90/p99 wall times, so runs before and after a change can be
+// compared directly (run from the repository root, like build/simple).
+
+using bench_clock = chrono::steady_clock;
+
+struct Samples {
+	vector<double> seconds;
+
+	double percentile(double p) const {
+		vector<double> sorted = seconds;
+		sort(sorted.begin(), sorted.end());
+		size_t k = size_t(round(p * (sorted.size() - 1)));
+		return sorted[k];
+	}
+};
+
+struct Row {
+	string tier, instance, benchmark;
+	Samples samples;
+};
+
+template <typename F> Samples measure(size_t repeats, F f) {
+	Samples samples;
+	for (size_t r = 0; r < repeats; ++r) {
+		auto start = bench_clock::now();
+		f();
+		samples.seconds.push_back(
+				chrono::duration<double>(bench_clock::now() - start).count());
+	}
+	return samples;
+}
+
+// time spent in one profiling timer during f, repeated
+template <typename F>
+Samples measure_timer(size_t repeats, const char* timer, F f) {
+	Samples samples;
+	for (size_t r = 0; r < repeats; ++r) {
+		profiling::take();
+		f();
+		auto registry = profiling::take();
+		samples.seconds.push_back(double(registry.timers[timer].nanos) * 1e-9);
+	}
+	return samples;
+}
+
+string read_all(const string& path) {
+	ifstream ifs(path);
+	if (!ifs)
+		throw runtime_error("cannot open " + path);
+	stringstream ss;
+	ss << ifs.rdbuf();
+	return ss.str();
+}
+
+void print_row(ostream& out, const Row& row, bool csv) {
+	const auto& s = row.samples;
+	if (csv) {
+		out << row.tier << ',' << row.instance << ',' << row.benchmark << ','
+				<< s.seconds.size() << ',' << s.percentile(0) << ','
+				<< s.percentile(0.5) << ',' << s.percentile(0.9) << ','
+				<< s.percentile(0.99) << '\n';
+		return;
+	}
+	out << fixed << setprecision(6) << left << setw(7) << row.tier << setw(34)
+			<< row.instance << setw(20) << row.benchmark << right << setw(6)
+			<< s.seconds.size() << setw(12) << s.percentile(0) << setw(12)
+			<< s.percentile(0.5) << setw(12) << s.percentile(0.9) << setw(12)
+			<< s.percentile(0.99) << '\n';
+}
+
+int main(int argc, char* argv[]) {
+	string list = "bench_instance_list.txt";
+	string filter;
+	string csv_file;
+	size_t repeats = 5;
+	size_t expand_samples = 200;
+	for (int i = 1; i < argc; ++i) {
+		string cur(argv[i]);
+		auto eq = [&](const auto& a) { return cur == string(a); };
+		auto next = [&]() { return string(argv[++i]); };
+		if (eq("-h") || eq("--help")) {
+			cerr << "Example usage: build/bench --repeats 10 --filter maze --csv "
+							"bench.csv"
+					 << endl;
+			return 0;
+		} else if (eq("--list"))
+			list = next();
+		else if (eq("--filter"))
+			filter = next();
+		else if (eq("--csv"))
+			csv_file = next();
+		else if (eq("--repeats"))
+			repeats = stoul(next());
+		else if (eq("--expand-samples"))
+			expand_samples = stoul(next());
+		else
+			cerr << "Unknown command-line option: " << cur << endl;
+	}
+	repeats = max<size_t>(repeats, 1);
+	profiling::enabled = true;
+
+	vector<pair<string, string>> entries;
+	{
+		ifstream ifs(list);
+		string line;
+		while (getline(ifs, line)) {
+			if (line.empty() || line[0] == '#')
+				continue;
+			istringstream ls(line);
+			string tier, path;
+			ls >> tier >> path;
+			if (filter.empty() || path.find(filter) != string::npos ||
+					tier == filter)
+				entries.emplace_back(tier, path);
+		}
+	}
+	if (entries.empty()) {
+		cerr << "No benchmark instances found in " << list << endl;
+		return 1;
+	}
+
+	cout << left << setw(7) << "tier" << setw(34) << "instance" << setw(20)
+			 << "benchmark" << right << setw(6) << "runs" << setw(12) << "min"
+			 << setw(12) << "median" << setw(12) << "p90" << setw(12) << "p99"
+			 << '\n';
+	vector<Row> rows;
+	auto report = [&](const string& tier, const string& name,
+										const string& benchmark, Samples samples) {
+		rows.push_back(Row{tier, name, benchmark, std::move(samples)});
+		print_row(cout, rows.back(), false);
+		cout.flush();
+	};
+
+	for (const auto& [tier, path] : entries) {
+		string name = remove_ext(path);
+		string text;
+		try {
+			text = read_all(in_file_full(name));
+		} catch (const exception& e) {
+			cerr << "Skipping " << name << ": " << e.what() << endl;
+			continue;
+		}
+
+		report(tier, name, "Instance::read", measure(repeats, [&]() {
+						 istringstream iss(text);
+						 string out_name;
+						 Instance::read(iss, out_name);
+					 }));
+		istringstream iss(text);
+		string out_name;
+		Instance inst = Instance::read(iss, out_name);
+		inst.complement();
+
+		Solution tri;
+		report(tier, name, "basicTriangulation", measure(repeats, [&]() {
+						 tri = basicTriangulation(inst);
+					 }));
+		report(tier, name, "mark_domains",
+					 measure_timer(repeats, "triangulate.mark_domains",
+												 [&]() { basicTriangulation(inst); }));
+
+		// fixed sample of (polygon, neighbouring polygon) expansion attempts
+		{
+			CoverageIndex index(inst, tri.polygons());
+			mt19937 rng(12345);
+			vector<pair<size_t, size_t>> pairs;
+			for (size_t k = 0; k < expand_samples && !tri.polygons().empty(); ++k) {
+				size_t i = rng() % tri.polygons().size();
+				auto near = index.overlapping(i);
+				if (!near.empty())
+					pairs.emplace_back(near[rng() % near.size()], i);
+			}
+			report(tier, name, "greedy_expand", measure(repeats, [&]() {
+							 for (auto [target, source] : pairs) {
+								 vector<Point> desired(tri.polygons()[source].begin(),
+																			 tri.polygons()[source].end());
+								 bool allCovered = false;
+								 greedy_expand(inst, tri.polygons()[target], desired,
+															 allCovered);
+							 }
+						 }));
+		}
+
+		// the same triangles in Hilbert order (as produced) and shuffled, to
+		// see what the memory locality of sort_by_hilbert is worth
+		{
+			vector<SimplePolygon> shuffled = tri.polygons();
+			shuffle(shuffled.begin(), shuffled.end(), mt19937(12345));
+			for (bool sorted : {true, false}) {
+				const auto& polys = sorted ? tri.polygons() : shuffled;
+				string order = sorted ? ".hilbert" : ".shuffled";
+				CoverageIndex index(inst, polys);
+				size_t found = 0;
+				report(tier, name, "overlapping" + order, measure(repeats, [&]() {
+								 for (size_t i = 0; i < polys.size(); ++i)
+									 found += index.overlapping(i).size();
+							 }));
+				report(tier, name, "removal_pass" + order,
+							 measure(repeats, [&]() {
+								 Solution copy(polys.begin(), polys.end());
+								 CoverageIndex copy_index(inst, copy.polygons());
+								 removal_pass(inst, copy, false, expand_samples, 0,
+															&copy_index);
+							 }));
+			}
+		}
+
+		Solution sol = solution_exists(name) ? Solution::read_file(name) : tri;
+		report(tier, name, "get_missing", measure(repeats, [&]() {
+						 get_missing(inst, sol.polygons());
+					 }));
+		report(tier, name, "verify", measure(repeats, [&]() {
+						 // a fresh copy, so the cached coverage is recomputed
+						 Solution copy(sol.polygons().begin(), sol.polygons().end());
+						 SolutionVerifier sv(&inst, &copy);
+						 sv.verify();
+					 }));
+		report(tier, name, "Solution::write", measure(repeats, [&]() {
+						 ostringstream oss;
+						 sol.write(oss, name);
+					 }));
+	}
+
+	if (!csv_file.empty()) {
+		ofstream ofs(csv_file);
+		ofs << "tier,instance,benchmark,runs,min,median,p90,p99\n";
+		for (const auto& row : rows)
+			print_row(ofs, row, true);
+	}
+}
@@ -18,8 +18,11 @@ using VertexHandle = Arrangement::Vertex_handle;
 using FaceHandle = Arrangement::Face_handle;
 using Rect = CGAL::Iso_rectangle_2<Kernel>;
 using HalfedgeCirc = Arrangement::Ccb_halfedge_circulator;
-using Visibility = CGAL::Triangular_expansion_visibility_2<Arrangement>;
+// triangular expansion needs a plain Arrangement_2 (without history)
+using Visibility = CGAL::Triangular_expansion_visibility_2<SimpleArrangement>;
 using Location = CGAL::Arr_trapezoid_ric_point_location<Arrangement>;
+using SimpleLocation =
+		CGAL::Arr_trapezoid_ric_point_location<SimpleArrangement>;
 using LocationResult = CGAL::Arr_point_location_result<Arrangement>::Type;
 
 } // namespace cgshop2023
@@ -1,10 +1,21 @@
 #include "cpp_instance.hpp"
+#include "cgshop2023_core/profiling.hpp"
+#include "cgshop2023_core/solution_store.hpp"
 #include "cgshop2023_core/verify.hpp"
+#include <CGAL/Boolean_set_operations_2.h>
+#include <atomic>
 #include <exception>
+#include <filesystem>
+#include <functional>
 #include <nlohmann/json.hpp>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <type_traits>
+#include <unistd.h>
+
+template class CGAL::Polygon_2<CGAL::Epeck>;
+template class CGAL::Polygon_with_holes_2<CGAL::Epeck>;
 
 std::string remove_ext(std::string s) {
 	size_t last_slash = s.find_last_of("/");
@@ -118,6 +129,73 @@ static void write_point_container_container_exact(std::ostream& out,
 	out << "\n]";
 }
 
+std::uint64_t Instance::next_id() {
+	static std::atomic<std::uint64_t> ids{0};
+	return ++ids;
+}
+
+Kernel::FT Instance::exact_area(const Polygon& polygon) {
+	Kernel::FT result = cgshop2023::area(polygon);
+	// evaluate now, so the lazy value is never updated by concurrent readers
+	CGAL::exact(result);
+	return result;
+}
+
+const std::vector<Polygon>& Instance::complement() const {
+	if (m_complement.empty()) {
+		CGAL::complement(m_polygon, std::back_inserter(m_complement));
+	}
+	return m_complement;
+}
+
+const std::vector<Polygon>& Solution::coverage() const {
+	if (!m_polygons.empty() && m_coverage.empty()) {
+		CGAL::join(polygons().begin(), polygons().end(),
+							 std::back_inserter(m_coverage));
+	}
+	return m_coverage;
+}
+
+const Kernel::FT& Solution::total_area() const {
+	if (!m_total_area) {
+		Kernel::FT sum = 0;
+		for (const auto& poly : m_polygons)
+			sum += CGAL::abs(poly.area());
+		m_total_area = sum;
+	}
+	return *m_total_area;
+}
+
+static Point deep_copy(const Point& p) {
+	return Point(Kernel::FT(p.x().exact()), Kernel::FT(p.y().exact()));
+}
+
+static SimplePolygon deep_copy(const SimplePolygon& poly) {
+	std::vector<Point> points;
+	points.reserve(poly.size());
+	for (const auto& p : poly)
+		points.push_back(deep_copy(p));
+	return SimplePolygon(points.begin(), points.end());
+}
+
+Instance Instance::deep_copy() const {
+	std::vector<SimplePolygon> holes;
+	for (const auto& hole : m_polygon.holes())
+		holes.push_back(cgshop2023::deep_copy(hole));
+	Instance copy(Polygon(cgshop2023::deep_copy(m_polygon.outer_boundary()),
+												holes.begin(), holes.end()));
+	copy.m_id = m_id;
+	return copy;
+}
+
+Solution Solution::deep_copy() const {
+	std::vector<SimplePolygon> polygons;
+	polygons.reserve(m_polygons.size());
+	for (const auto& poly : m_polygons)
+		polygons.push_back(cgshop2023::deep_copy(poly));
+	return Solution(std::move(polygons));
+}
+
 void Instance::write(std::ostream& output, const std::string& name) {
 	output << '{';
 	write_kv(output, "type", "CGSHOP2023_Instance");
@@ -146,6 +224,7 @@ void Instance::write(std::ostream& output, const std::string& name) {
 }
 
 void Solution::write(std::ostream& output, const std::string& name) {
+	profiling::ScopedTimer timer("write");
 	output << '{';
 	write_kv(output, "type", "CGSHOP2023_Solution");
 	output << ",\n";
@@ -188,6 +267,7 @@ static SimplePolygon json_to_rational_points(const nlohmann::json& plist) {
 }
 
 Instance Instance::read(std::istream& input, std::string& out_name) {
+	profiling::ScopedTimer timer("parse.instance");
 	nlohmann::json jsdata;
 	input >> jsdata;
 	if (jsdata.at("type") != "CGSHOP2023_Instance") {
@@ -206,6 +286,7 @@ Instance Instance::read(std::istream& input, std::string& out_name) {
 }
 
 Solution Solution::read(std::istream& input) {
+	profiling::ScopedTimer timer("parse.solution");
 	nlohmann::json jsdata;
 	input >> jsdata;
 	if (jsdata.at("type") != "CGSHOP2023_Solution") {
@@ -241,31 +322,32 @@ bool solution_exists(const std::string& name) {
 	return ifs.is_open();
 }
 
-bool Solution::write_if_better(const Instance& inst, const std::string& name) {
-	SolutionVerifier svN(&inst, this);
-	if (!solution_exists(name) && svN.verify()) {
-		cerr << "No existing saved solution for " << name
-				 << ". This one is valid, writing it (size=" << size() << ")." << endl;
-		string out_name = out_file_full(name);
-		ofstream ofs(out_name);
+void Solution::write_to(const std::string& path, const std::string& name) {
+	// write next to the target and rename over it, so readers (and a crash
+	// mid-write) only ever see a complete file; the temporary name is unique
+	// per host, process and thread, as the directory may be shared
+	char host[256] = "";
+	gethostname(host, sizeof(host) - 1);
+	auto thread = std::hash<std::thread::id>{}(std::this_thread::get_id());
+	string tmp_name = path + ".tmp" + host + "-" + std::to_string(getpid()) +
+										"-" + std::to_string(thread);
+	{
+		ofstream ofs(tmp_name);
 		write(ofs, remove_ext(name));
-		return true;
+		if (!ofs.flush())
+			throw std::runtime_error("could not write " + tmp_name);
 	}
-	Solution sol_old = Solution::read_file(name);
-	SolutionVerifier svO(&inst, &sol_old);
-	if (!svN.verify()) {
-		cerr << "Warning: Tried to save invalid solution for " << name << endl;
-		return false;
-	}
-	if (!svO.verify() || size() < sol_old.size()) {
-		cerr << "Found solution improvement for " << name << ": " << sol_old.size()
-				 << "->" << size() << endl;
-		string out_name = out_file_full(name);
-		ofstream ofs(out_name);
-		write(ofs, remove_ext(name));
-		return true;
-	}
-	return false;
+	std::filesystem::rename(tmp_name, path);
+}
+
+void Solution::write_file(const std::string& name) {
+	write_to(out_file_full(name), name);
+}
+
+bool Solution::write_if_better(const Instance& inst, const std::string& name) {
+	profiling::ScopedTimer timer("write_if_better");
+	return SolutionStore().commit(inst, name, *this) ==
+				 SolutionStore::Result::Written;
 }
 
 } // namespace cgshop2023
@@ -1,17 +1,24 @@
 #pragma once
 
-#include <CGAL/Boolean_set_operations_2.h>
+#include "int_geometry.hpp"
 #include <CGAL/Exact_predicates_exact_constructions_kernel.h>
 #include <CGAL/Point_2.h>
 #include <CGAL/Polygon_2.h>
 #include <CGAL/Polygon_with_holes_2.h>
 #include <algorithm>
+#include <cstdint>
 #include <initializer_list>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
+// The polygon types are instantiated once, in cpp_instance.cpp, instead of in
+// every translation unit that uses them.
+extern template class CGAL::Polygon_2<CGAL::Epeck>;
+extern template class CGAL::Polygon_with_holes_2<CGAL::Epeck>;
+
 std::string remove_ext(std::string s);
 
 std::string in_file_full(std::string name);
@@ -28,12 +35,23 @@ using std::string;
 
 Kernel::FT area(const Polygon& polygon);
 
+bool solution_exists(const std::string& name);
+
 class Instance {
 public:
-	explicit Instance(const Polygon& poly) : m_polygon(poly) {}
-	explicit Instance(Polygon&& poly) : m_polygon(std::move(poly)) {}
+	explicit Instance(const Polygon& poly) : m_polygon(poly), m_boundary(poly) {}
+	explicit Instance(Polygon&& poly)
+			: m_polygon(std::move(poly)), m_boundary(m_polygon) {}
 	[[nodiscard]] const Polygon& polygon() const noexcept { return m_polygon; }
 
+	// exact area of polygon(), computed once on construction
+	[[nodiscard]] const Kernel::FT& area() const noexcept { return m_area; }
+
+	// integer copy of the boundary, for exact tests without the lazy kernel
+	[[nodiscard]] const IntBoundary& boundary() const noexcept {
+		return m_boundary;
+	}
+
 	void write(std::ostream& output, const std::string& name);
 	static Instance read(std::istream& input, std::string& out_name);
 	static Instance read_file(const std::string& name);
@@ -45,8 +63,28 @@ public:
 				[](const auto& hole) { return hole.container().size(); });
 	}
 
+	// the pieces of the plane outside of polygon(), computed on first use (so
+	// call it once before sharing an instance between threads)
+	[[nodiscard]] const std::vector<Polygon>& complement() const;
+
+	// unique per constructed instance (copies share it), for caches that
+	// outlive a single search call
+	[[nodiscard]] std::uint64_t id() const noexcept { return m_id; }
+
+	// copy sharing no lazy kernel objects with this one (see
+	// Solution::deep_copy), with the same id
+	[[nodiscard]] Instance deep_copy() const;
+
 private:
+	static std::uint64_t next_id();
+
+	static Kernel::FT exact_area(const Polygon& polygon);
+
 	Polygon m_polygon;
+	IntBoundary m_boundary;
+	Kernel::FT m_area = exact_area(m_polygon);
+	std::uint64_t m_id = next_id();
+	mutable std::vector<Polygon> m_complement = {};
 };
 
 class Solution {
@@ -68,29 +106,44 @@ public:
 	void write(std::ostream& output, const std::string& name);
 	static Solution read(std::istream& input);
 	static Solution read_file(const std::string& name);
+	// atomically replace the file at path by the solution, written for the
+	// instance name (write a temporary file, then rename)
+	void write_to(const std::string& path, const std::string& name);
+	// write_to the saved solution of name
+	void write_file(const std::string& name);
+	// SolutionStore::commit with the default store
 	bool write_if_better(const Instance& inst, const std::string& name);
 
 	[[nodiscard]] const std::vector<SimplePolygon>& polygons() const noexcept {
 		return m_polygons;
 	}
 
+	// mutable access, which drops the cached coverage and area
 	[[nodiscard]] std::vector<SimplePolygon>& polygons_m() noexcept {
+		m_coverage.clear();
+		m_total_area.reset();
 		return m_polygons;
 	}
 
 	[[nodiscard]] size_t size() const { return m_polygons.size(); }
 
-	[[nodiscard]] const std::vector<Polygon>& coverage() const {
-		if (!m_polygons.empty() && m_coverage.empty()) {
-			CGAL::join(polygons().begin(), polygons().end(),
-								 std::back_inserter(m_coverage));
-		}
-		return m_coverage;
-	}
+	// Copy rebuilt from the exact coordinates, sharing no lazy kernel objects
+	// with this one. Epeck numbers in CGAL 5.0 are reference counted and
+	// evaluated without synchronization, so an object is only ever touched by
+	// one thread at a time; handing a cover to another thread takes a deep
+	// copy made while holding the original.
+	[[nodiscard]] Solution deep_copy() const;
+
+	[[nodiscard]] const std::vector<Polygon>& coverage() const;
+
+	// exact sum of the (unsigned) polygon areas, an upper bound on the area
+	// the polygons cover
+	[[nodiscard]] const Kernel::FT& total_area() const;
 
 private:
 	std::vector<SimplePolygon> m_polygons;
 	mutable std::vector<Polygon> m_coverage = {};
+	mutable std::optional<Kernel::FT> m_total_area = {};
 };
 
 } // namespace cgshop2023
@@ -0,0 +1,68 @@
+#include "hilbert_order.hpp"
+#include "profiling.hpp"
+#include <CGAL/Bbox_2.h>
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+namespace cgshop2023 {
+
+constexpr std::uint32_t HILBERT_SIDE = 1u << 16;
+
+std::uint64_t hilbert_index(std::uint32_t x, std::uint32_t y) {
+	std::uint64_t d = 0;
+	for (std::uint32_t s = HILBERT_SIDE / 2; s > 0; s /= 2) {
+		std::uint32_t rx = (x & s) > 0;
+		std::uint32_t ry = (y & s) > 0;
+		d += std::uint64_t(s) * s * ((3 * rx) ^ ry);
+		// rotate the quadrant so the curve inside it starts at its origin
+		if (ry == 0) {
+			if (rx == 1) {
+				x = HILBERT_SIDE - 1 - x;
+				y = HILBERT_SIDE - 1 - y;
+			}
+			std::swap(x, y);
+		}
+	}
+	return d;
+}
+
+void sort_by_hilbert(std::vector<SimplePolygon>& polys) {
+	profiling::ScopedTimer timer("hilbert_sort");
+	std::size_t n = polys.size();
+	if (n < 2)
+		return;
+	std::vector<std::pair<double, double>> centres(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		CGAL::Bbox_2 box = polys[i].bbox();
+		centres[i] = {(box.xmin() + box.xmax()) / 2, (box.ymin() + box.ymax()) / 2};
+	}
+	auto point_box = [](const std::pair<double, double>& c) {
+		return CGAL::Bbox_2(c.first, c.second, c.first, c.second);
+	};
+	CGAL::Bbox_2 extent = point_box(centres[0]);
+	for (const auto& c : centres)
+		extent += point_box(c);
+	double scale = (HILBERT_SIDE - 1) /
+								 std::max({extent.xmax() - extent.xmin(),
+													 extent.ymax() - extent.ymin(), 1e-300});
+	std::vector<std::uint64_t> keys(n);
+	for (std::size_t i = 0; i < n; ++i)
+		keys[i] = hilbert_index(
+				std::uint32_t((centres[i].first - extent.xmin()) * scale),
+				std::uint32_t((centres[i].second - extent.ymin()) * scale));
+
+	std::vector<std::size_t> order(n);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(),
+									 [&](std::size_t i, std::size_t j) {
+										 return keys[i] < keys[j];
+									 });
+	std::vector<SimplePolygon> sorted;
+	sorted.reserve(n);
+	for (std::size_t i : order)
+		sorted.push_back(std::move(polys[i]));
+	polys = std::move(sorted);
+}
+
+} // namespace cgshop2023
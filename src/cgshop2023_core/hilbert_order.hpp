@@ -0,0 +1,23 @@
+#pragma once
+
+//
+// Ordering of cover polygons along a Hilbert curve, for memory locality.
+//
+
+#include "cpp_instance.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace cgshop2023 {
+
+// position of cell (x, y) of a 2^16 x 2^16 grid along the Hilbert curve
+// through it
+std::uint64_t hilbert_index(std::uint32_t x, std::uint32_t y);
+
+// Sort polys by the Hilbert index of their bounding box centres on a grid
+// over all the centres, so polygons that are close in the plane are mostly
+// close in the vector. Equal indices keep their order, which makes sorting a
+// sorted cover a no-op.
+void sort_by_hilbert(std::vector<SimplePolygon>& polys);
+
+} // namespace cgshop2023
@@ -0,0 +1,283 @@
+#include "int_geometry.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace cgshop2023 {
+
+static bool is_int_coord(double v) {
+	return std::abs(v) < INT_COORD_LIMIT && std::floor(v) == v;
+}
+
+bool to_int_point(const CGAL::Point_2<CGAL::Epeck>& p, IntPoint& out) {
+	auto x = CGAL::to_interval(p.x());
+	auto y = CGAL::to_interval(p.y());
+	if (x.first != x.second || y.first != y.second)
+		return false;
+	if (!is_int_coord(x.first) || !is_int_coord(y.first))
+		return false;
+	out = IntPoint{std::int64_t(x.first), std::int64_t(y.first)};
+	return true;
+}
+
+IntBoundary::IntBoundary(
+		const CGAL::Polygon_with_holes_2<CGAL::Epeck>& polygon) {
+	auto add_ring = [&](const CGAL::Polygon_2<CGAL::Epeck>& ring) {
+		std::vector<IntPoint> points;
+		for (const auto& p : ring.container()) {
+			IntPoint q;
+			if (!to_int_point(p, q))
+				return false;
+			points.push_back(q);
+		}
+		for (std::size_t i = 0; i < points.size(); ++i)
+			m_edges.push_back(Edge{points[i], points[(i + 1) % points.size()]});
+		return true;
+	};
+	m_bbox = polygon.outer_boundary().bbox();
+	if (!add_ring(polygon.outer_boundary()))
+		return;
+	for (const auto& hole : polygon.holes())
+		if (!add_ring(hole))
+			return;
+	if (m_edges.empty())
+		return;
+
+	m_xmin = m_xmax = m_edges[0].a.x;
+	m_ymin = m_ymax = m_edges[0].a.y;
+	for (const Edge& e : m_edges) {
+		m_xmin = std::min(m_xmin, e.a.x);
+		m_xmax = std::max(m_xmax, e.a.x);
+		m_ymin = std::min(m_ymin, e.a.y);
+		m_ymax = std::max(m_ymax, e.a.y);
+	}
+	std::size_t side = std::size_t(std::ceil(std::sqrt(double(m_edges.size()))));
+	m_nx = m_ny = std::clamp<std::size_t>(side, 1, 1024);
+	m_cell_w = std::max((double(m_xmax) - double(m_xmin)) / double(m_nx), 1.0);
+	m_cell_h = std::max((double(m_ymax) - double(m_ymin)) / double(m_ny), 1.0);
+
+	// two passes over the edges: count per cell, then fill
+	m_cell_start.assign(m_nx * m_ny + 1, 0);
+	auto for_cells = [&](const Edge& e, auto&& f) {
+		std::size_t x0 = cell_x(std::min(e.a.x, e.b.x));
+		std::size_t x1 = cell_x(std::max(e.a.x, e.b.x));
+		std::size_t y0 = cell_y(std::min(e.a.y, e.b.y));
+		std::size_t y1 = cell_y(std::max(e.a.y, e.b.y));
+		for (std::size_t cy = y0; cy <= y1; ++cy)
+			for (std::size_t cx = x0; cx <= x1; ++cx)
+				f(cy * m_nx + cx);
+	};
+	for (const Edge& e : m_edges)
+		for_cells(e, [&](std::size_t c) { ++m_cell_start[c + 1]; });
+	for (std::size_t c = 0; c + 1 < m_cell_start.size(); ++c)
+		m_cell_start[c + 1] += m_cell_start[c];
+	m_cell_edges.resize(m_cell_start.back());
+	std::vector<std::uint32_t> fill(m_cell_start.begin(), m_cell_start.end() - 1);
+	for (std::size_t i = 0; i < m_edges.size(); ++i)
+		for_cells(m_edges[i], [&](std::size_t c) {
+			m_cell_edges[fill[c]++] = std::uint32_t(i);
+		});
+	m_valid = true;
+}
+
+// monotone in x, which is all that is needed for the bounding box queries
+std::size_t IntBoundary::cell_x(std::int64_t x) const {
+	double c = std::floor((double(x) - double(m_xmin)) / m_cell_w);
+	return std::size_t(std::clamp(c, 0.0, double(m_nx - 1)));
+}
+
+std::size_t IntBoundary::cell_y(std::int64_t y) const {
+	double c = std::floor((double(y) - double(m_ymin)) / m_cell_h);
+	return std::size_t(std::clamp(c, 0.0, double(m_ny - 1)));
+}
+
+void IntBoundary::edges_near(std::int64_t xmin, std::int64_t ymin,
+														 std::int64_t xmax, std::int64_t ymax,
+														 std::vector<std::uint32_t>& out) const {
+	out.clear();
+	if (xmax < m_xmin || xmin > m_xmax || ymax < m_ymin || ymin > m_ymax)
+		return;
+	std::size_t x0 = cell_x(xmin), x1 = cell_x(xmax);
+	std::size_t y0 = cell_y(ymin), y1 = cell_y(ymax);
+	for (std::size_t cy = y0; cy <= y1; ++cy)
+		for (std::size_t cx = x0; cx <= x1; ++cx) {
+			std::size_t c = cy * m_nx + cx;
+			out.insert(out.end(), m_cell_edges.begin() + m_cell_start[c],
+								 m_cell_edges.begin() + m_cell_start[c + 1]);
+		}
+	if (x0 != x1 || y0 != y1) {
+		std::sort(out.begin(), out.end());
+		out.erase(std::unique(out.begin(), out.end()), out.end());
+	}
+}
+
+static std::int64_t floor_div(__int128 v, std::int64_t d) {
+	__int128 q = v / d;
+	if (q * d != v && v < 0)
+		--q;
+	return std::int64_t(q);
+}
+
+bool IntBoundary::inside_scaled(__int128 qx, __int128 qy,
+																std::int64_t scale) const {
+	// crossing number of the ray from q in +x direction; only edges in the
+	// rows around q, from its column on, can cross it
+	std::int64_t fx = floor_div(qx, scale);
+	std::int64_t fy = floor_div(qy, scale);
+	if (fx + 1 < m_xmin || fx > m_xmax || fy + 1 < m_ymin || fy > m_ymax)
+		return false;
+	thread_local std::vector<std::uint32_t> candidates;
+	edges_near(fx, fy, m_xmax, fy + 1, candidates);
+	bool inside = false;
+	for (std::uint32_t i : candidates) {
+		const Edge& e = m_edges[i];
+		__int128 ax = __int128(e.a.x) * scale, ay = __int128(e.a.y) * scale;
+		__int128 bx = __int128(e.b.x) * scale, by = __int128(e.b.y) * scale;
+		if ((ay > qy) == (by > qy))
+			continue;
+		__int128 d = (bx - ax) * (qy - ay) - (by - ay) * (qx - ax);
+		// upwards edges cross to the right of q iff q is left of them
+		if (by > ay ? d > 0 : d < 0)
+			inside = !inside;
+	}
+	return inside;
+}
+
+static int scaled_orientation(__int128 ax, __int128 ay, __int128 bx,
+															__int128 by, __int128 cx, __int128 cy) {
+	__int128 d = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+	return (d > 0) - (d < 0);
+}
+
+bool IntBoundary::segment_crosses(const IntPoint& a, const IntPoint& b,
+																	std::int64_t scale) const {
+	thread_local std::vector<std::uint32_t> candidates;
+	edges_near(floor_div(std::min(a.x, b.x), scale),
+						 floor_div(std::min(a.y, b.y), scale),
+						 floor_div(std::max(a.x, b.x), scale) + 1,
+						 floor_div(std::max(a.y, b.y), scale) + 1, candidates);
+	for (std::uint32_t i : candidates) {
+		const Edge& e = m_edges[i];
+		__int128 ex = __int128(e.a.x) * scale, ey = __int128(e.a.y) * scale;
+		__int128 fx = __int128(e.b.x) * scale, fy = __int128(e.b.y) * scale;
+		int oa = scaled_orientation(ex, ey, fx, fy, a.x, a.y);
+		int ob = scaled_orientation(ex, ey, fx, fy, b.x, b.y);
+		if (oa * ob >= 0)
+			continue;
+		int oe = scaled_orientation(a.x, a.y, b.x, b.y, ex, ey);
+		int of = scaled_orientation(a.x, a.y, b.x, b.y, fx, fy);
+		if (oe * of < 0)
+			return true;
+	}
+	return false;
+}
+
+bool IntBoundary::segment_leaves(const IntPoint& a,
+																 const IntPoint& b) const {
+	if (segment_crosses(a, b))
+		return true;
+	// Without proper crossings the boundary only meets the segment in boundary
+	// vertices on it and in edges along it. Between two consecutive such
+	// vertices the segment is inside, outside or on the boundary as a whole,
+	// which its midpoint decides (scaled by 2 to keep it integral).
+	thread_local std::vector<std::uint32_t> candidates;
+	edges_near(std::min(a.x, b.x), std::min(a.y, b.y), std::max(a.x, b.x),
+						 std::max(a.y, b.y), candidates);
+	auto on_segment = [&](const IntPoint& p, const IntPoint& s,
+												const IntPoint& t) {
+		return int_orientation(s, t, p) == 0 && std::min(s.x, t.x) <= p.x &&
+					 p.x <= std::max(s.x, t.x) && std::min(s.y, t.y) <= p.y &&
+					 p.y <= std::max(s.y, t.y);
+	};
+	// stops along the segment, by their (scaled) distance from a
+	thread_local std::vector<std::pair<__int128, IntPoint>> stops;
+	stops.clear();
+	auto along = [&](const IntPoint& p) {
+		return __int128(p.x - a.x) * (b.x - a.x) +
+					 __int128(p.y - a.y) * (b.y - a.y);
+	};
+	stops.emplace_back(along(a), a);
+	stops.emplace_back(along(b), b);
+	for (std::uint32_t i : candidates)
+		if (on_segment(m_edges[i].a, a, b))
+			stops.emplace_back(along(m_edges[i].a), m_edges[i].a);
+	std::sort(stops.begin(), stops.end(),
+						[](const auto& s, const auto& t) { return s.first < t.first; });
+
+	for (std::size_t i = 0; i + 1 < stops.size(); ++i) {
+		if (stops[i].first == stops[i + 1].first)
+			continue;
+		const IntPoint& p = stops[i].second;
+		const IntPoint& q = stops[i + 1].second;
+		__int128 mx = __int128(p.x) + q.x, my = __int128(p.y) + q.y;
+		// stops are consecutive, so the piece between them is on the boundary
+		// iff a single edge contains both
+		bool on_boundary = false;
+		for (std::uint32_t j : candidates) {
+			const Edge& e = m_edges[j];
+			if (on_segment(p, e.a, e.b) && on_segment(q, e.a, e.b)) {
+				on_boundary = true;
+				break;
+			}
+		}
+		if (!on_boundary && !inside_scaled(mx, my, 2))
+			return true;
+	}
+	return false;
+}
+
+bool IntBoundary::contains_convex(const std::vector<IntPoint>& hull) const {
+	std::size_t n = hull.size();
+	// orientation of hull, and a triangle of hull vertices with positive area
+	int sign = 0;
+	std::size_t apex = 1;
+	for (; apex + 1 < n && sign == 0; ++apex)
+		sign = int_orientation(hull[0], hull[apex], hull[apex + 1]);
+	if (sign == 0)
+		return true; // degenerate, nothing to decide here
+	--apex;
+
+	std::int64_t xmin = hull[0].x, xmax = hull[0].x;
+	std::int64_t ymin = hull[0].y, ymax = hull[0].y;
+	for (const IntPoint& p : hull) {
+		xmin = std::min(xmin, p.x);
+		xmax = std::max(xmax, p.x);
+		ymin = std::min(ymin, p.y);
+		ymax = std::max(ymax, p.y);
+	}
+	thread_local std::vector<std::uint32_t> candidates;
+	edges_near(xmin, ymin, xmax, ymax, candidates);
+
+	// separating axis test between each edge and the open interior of hull;
+	// for a segment and a convex polygon the separating line can be taken
+	// through the segment or through an edge of the polygon
+	auto meets_interior = [&](const Edge& e) {
+		for (std::size_t i = 0; i < n; ++i) {
+			const IntPoint& h0 = hull[i];
+			const IntPoint& h1 = hull[(i + 1) % n];
+			if (sign * int_orientation(h0, h1, e.a) <= 0 &&
+					sign * int_orientation(h0, h1, e.b) <= 0)
+				return false;
+		}
+		bool left = false, right = false;
+		for (const IntPoint& h : hull) {
+			int o = int_orientation(e.a, e.b, h);
+			left = left || o > 0;
+			right = right || o < 0;
+		}
+		return left && right;
+	};
+	for (std::uint32_t i : candidates)
+		if (meets_interior(m_edges[i]))
+			return false;
+
+	// the interior of hull misses the boundary, so it is inside or outside as
+	// a whole; decide with the centroid of a triangle of it (scaled by 3 to
+	// keep it integral)
+	const IntPoint& a = hull[0];
+	const IntPoint& b = hull[apex];
+	const IntPoint& c = hull[apex + 1];
+	return inside_scaled(__int128(a.x) + b.x + c.x, __int128(a.y) + b.y + c.y,
+											 3);
+}
+
+} // namespace cgshop2023
@@ -0,0 +1,105 @@
+#pragma once
+
+//
+// Native integer twin of the instance boundary, with exact 128-bit predicates.
+//
+
+#include <CGAL/Bbox_2.h>
+#include <CGAL/Exact_predicates_exact_constructions_kernel.h>
+#include <CGAL/Point_2.h>
+#include <CGAL/Polygon_with_holes_2.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cgshop2023 {
+
+// Coordinates are bounded by 2^60 so that orientation tests, even on points
+// scaled by 3 (see IntBoundary::contains_convex), fit into __int128.
+constexpr double INT_COORD_LIMIT = 1152921504606846976.0;
+
+struct IntPoint {
+	std::int64_t x, y;
+};
+
+// sign of the orientation of (a, b, c): 1 for a left turn, -1 for a right
+// turn, 0 if collinear
+inline int int_orientation(const IntPoint& a, const IntPoint& b,
+													 const IntPoint& c) {
+	__int128 d = __int128(b.x - a.x) * (c.y - a.y) -
+							 __int128(b.y - a.y) * (c.x - a.x);
+	return (d > 0) - (d < 0);
+}
+
+// Convert p if its coordinates are known to be integers below
+// INT_COORD_LIMIT. Only the interval approximation of the lazy kernel is
+// looked at, so this never triggers an exact evaluation; points that were
+// constructed and not yet evaluated simply do not convert.
+bool to_int_point(const CGAL::Point_2<CGAL::Epeck>& p, IntPoint& out);
+
+// The boundary edges of an instance with integer vertices (outer boundary and
+// holes alike), in a uniform grid keyed by their bounding boxes. Tests that
+// only involve the boundary and integer points are answered here with plain
+// integer arithmetic instead of going through the lazy exact kernel.
+class IntBoundary {
+public:
+	struct Edge {
+		IntPoint a, b;
+	};
+
+	IntBoundary() = default;
+	explicit IntBoundary(const CGAL::Polygon_with_holes_2<CGAL::Epeck>& polygon);
+
+	// false if some vertex of the instance is not a small enough integer point;
+	// then none of the queries below may be used
+	[[nodiscard]] bool valid() const noexcept { return m_valid; }
+
+	// (conservative) bounding box of the instance
+	[[nodiscard]] const CGAL::Bbox_2& bbox() const noexcept { return m_bbox; }
+
+	[[nodiscard]] std::size_t num_edges() const noexcept {
+		return m_edges.size();
+	}
+	[[nodiscard]] const Edge& edge(std::size_t i) const { return m_edges[i]; }
+
+	// indices of the edges whose bounding box may meet the given box
+	void edges_near(std::int64_t xmin, std::int64_t ymin, std::int64_t xmax,
+									std::int64_t ymax, std::vector<std::uint32_t>& out) const;
+
+	// Is the convex polygon hull (either orientation, positive area) contained
+	// in the closed instance? True iff no boundary edge meets the interior of
+	// hull and an interior point of hull lies inside the instance.
+	[[nodiscard]] bool contains_convex(const std::vector<IntPoint>& hull) const;
+
+	// Does some boundary edge properly cross the segment from a / scale to
+	// b / scale (meeting it in a single point interior to both)? Then the
+	// segment certainly leaves the instance. scale is 1 or 3, the latter for
+	// segments from a triangle centroid.
+	[[nodiscard]] bool segment_crosses(const IntPoint& a, const IntPoint& b,
+																		 std::int64_t scale = 1) const;
+
+	// Does the segment from a to b leave the closed instance somewhere? Then no
+	// convex polygon inside the instance contains both a and b. Besides proper
+	// crossings this catches segments that only touch the boundary at vertices
+	// and run outside in between, like a chord across the mouth of a notch.
+	[[nodiscard]] bool segment_leaves(const IntPoint& a, const IntPoint& b) const;
+
+private:
+	// is (qx, qy) / scale strictly inside, given it is not on the boundary
+	[[nodiscard]] bool inside_scaled(__int128 qx, __int128 qy,
+																	 std::int64_t scale) const;
+	[[nodiscard]] std::size_t cell_x(std::int64_t x) const;
+	[[nodiscard]] std::size_t cell_y(std::int64_t y) const;
+
+	bool m_valid = false;
+	CGAL::Bbox_2 m_bbox;
+	std::vector<Edge> m_edges;
+	std::int64_t m_xmin = 0, m_ymin = 0, m_xmax = 0, m_ymax = 0;
+	double m_cell_w = 1, m_cell_h = 1;
+	std::size_t m_nx = 0, m_ny = 0;
+	// edges of cell c are m_cell_edges[m_cell_start[c] .. m_cell_start[c + 1])
+	std::vector<std::uint32_t> m_cell_start;
+	std::vector<std::uint32_t> m_cell_edges;
+};
+
+} // namespace cgshop2023
@@ -0,0 +1,191 @@
+#include "lower_bound.hpp"
+#include "hilbert_order.hpp"
+#include "profiling.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <random>
+
+namespace cgshop2023 {
+
+// other vertices each vertex is tested against to estimate what it sees
+constexpr std::size_t VISIBILITY_SAMPLES = 48;
+// the samples come from about this many vertices on either side along a
+// Hilbert curve, so the tested segments are short and cheap to check
+constexpr std::size_t SAMPLE_WINDOW = 4 * VISIBILITY_SAMPLES;
+// share of max_checks and max_seconds the sampling may use, the rest is left
+// to the greedy
+constexpr std::size_t SAMPLE_BUDGET_SHARE = 4;
+// orders tried by the greedy, the first one unperturbed
+constexpr std::size_t GREEDY_ROUNDS = 8;
+
+// indices of points, sorted along a Hilbert curve over their bounding box
+static std::vector<std::size_t>
+hilbert_sorted(const std::vector<IntPoint>& points) {
+	using limits = std::numeric_limits<std::int64_t>;
+	std::int64_t xmin = limits::max(), ymin = limits::max();
+	std::int64_t xmax = limits::min(), ymax = limits::min();
+	for (const IntPoint& p : points) {
+		xmin = std::min(xmin, p.x);
+		ymin = std::min(ymin, p.y);
+		xmax = std::max(xmax, p.x);
+		ymax = std::max(ymax, p.y);
+	}
+	double w = std::max<double>(double(xmax - xmin), 1);
+	double h = std::max<double>(double(ymax - ymin), 1);
+	std::vector<std::uint64_t> keys(points.size());
+	for (std::size_t i = 0; i < points.size(); ++i)
+		keys[i] = hilbert_index(
+				std::uint32_t(double(points[i].x - xmin) / w * 65535),
+				std::uint32_t(double(points[i].y - ymin) / h * 65535));
+	std::vector<std::size_t> order(points.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(),
+									 [&](std::size_t i, std::size_t j) {
+										 return keys[i] < keys[j];
+									 });
+	return order;
+}
+
+std::vector<IntPoint> independent_witnesses(const Instance& inst,
+																						std::size_t max_checks,
+																						double max_seconds) {
+	const IntBoundary& boundary = inst.boundary();
+	if (!boundary.valid())
+		return {};
+	profiling::ScopedTimer timer("lower_bound.compute");
+	std::vector<IntPoint> points;
+	points.reserve(boundary.num_edges());
+	for (std::size_t i = 0; i < boundary.num_edges(); ++i)
+		points.push_back(boundary.edge(i).a);
+	std::size_t n = points.size();
+	using clock = std::chrono::steady_clock;
+	auto start = clock::now();
+	auto after = [&](double seconds) {
+		return start + std::chrono::duration_cast<clock::duration>(
+											 std::chrono::duration<double>(seconds));
+	};
+	auto deadline = after(max_seconds / SAMPLE_BUDGET_SHARE);
+	std::size_t checks = 0;
+	bool timed_out = false;
+	auto sees = [&](const IntPoint& a, const IntPoint& b) {
+		// a test along many collinear boundary vertices can take milliseconds,
+		// so the clock is read every time
+		++checks;
+		if (clock::now() >= deadline)
+			timed_out = true;
+		return !boundary.segment_leaves(a, b);
+	};
+	auto exhausted = [&]() { return checks >= max_checks || timed_out; };
+	// hilbert[r] is the point of rank r along the curve, rank its inverse
+	std::vector<std::size_t> hilbert = hilbert_sorted(points);
+	std::vector<std::size_t> rank(n);
+	for (std::size_t r = 0; r < n; ++r)
+		rank[hilbert[r]] = r;
+
+	// fixed seed, so the bound of an instance does not change between runs
+	std::mt19937 rng{std::uint32_t(n)};
+	std::vector<double> seen(n, 0);
+	std::size_t samples =
+			n > 1 ? std::min({VISIBILITY_SAMPLES, n - 1,
+												max_checks / SAMPLE_BUDGET_SHARE / n})
+						: 0;
+	if (samples > 0) {
+		// what a vertex sees of its neighbourhood: the tips of spikes and
+		// pockets see little of it, reflex vertices most
+		std::size_t m = std::min(2 * SAMPLE_WINDOW, n - 1);
+		for (std::size_t r = 0; r < n && !timed_out; ++r) {
+			// m + 1 consecutive ranks around r (shifted at the ends), without r
+			std::size_t lo = r < m / 2 ? 0 : std::min(r - m / 2, n - 1 - m);
+			std::uniform_int_distribution<std::size_t> other(lo, lo + m - 1);
+			for (std::size_t s = 0; s < samples; ++s) {
+				std::size_t k = other(rng);
+				if (sees(points[hilbert[r]], points[hilbert[k < r ? k : k + 1]]))
+					seen[hilbert[r]] += 1;
+			}
+		}
+	}
+
+	// Is point i seen by none of the chosen (ranks, sorted)? Tested nearest
+	// along the curve first: most candidates are seen by a witness close by,
+	// which is also the cheapest segment to test. Out of time, it is left out.
+	auto independent = [&](const std::vector<std::size_t>& chosen,
+												 std::size_t i) {
+		std::size_t r = rank[i];
+		auto hi = std::lower_bound(chosen.begin(), chosen.end(), r);
+		auto lo = hi;
+		while (lo != chosen.begin() || hi != chosen.end()) {
+			bool left = hi == chosen.end() ||
+									(lo != chosen.begin() && r - lo[-1] < *hi - r);
+			std::size_t w = left ? *--lo : *hi++;
+			if (sees(points[i], points[hilbert[w]]) || timed_out)
+				return false;
+		}
+		return true;
+	};
+
+	deadline = after(max_seconds);
+	timed_out = false;
+	std::vector<std::size_t> best;
+	std::vector<std::size_t> order(n);
+	std::vector<double> key(n);
+	std::uniform_real_distribution<double> noise(0.5, 1.5);
+	for (std::size_t round = 0; round < GREEDY_ROUNDS && !exhausted();
+			 ++round) {
+		for (std::size_t i = 0; i < n; ++i)
+			key[i] = round == 0 ? seen[i] : seen[i] * noise(rng);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(),
+										 [&](std::size_t i, std::size_t j) {
+											 return key[i] < key[j];
+										 });
+		std::vector<std::size_t> chosen;
+		for (std::size_t i : order) {
+			if (exhausted())
+				break;
+			if (independent(chosen, i))
+				chosen.insert(
+						std::upper_bound(chosen.begin(), chosen.end(), rank[i]), rank[i]);
+		}
+		if (chosen.size() > best.size())
+			best = std::move(chosen);
+	}
+	profiling::count("lower_bound.checks", checks);
+	if (timed_out)
+		profiling::count("lower_bound.timeouts");
+	std::vector<IntPoint> witnesses;
+	witnesses.reserve(best.size());
+	for (std::size_t r : best)
+		witnesses.push_back(points[hilbert[r]]);
+	return witnesses;
+}
+
+namespace {
+std::mutex bounds_mutex;
+std::map<std::uint64_t, std::size_t> bounds;
+} // namespace
+
+std::size_t cover_lower_bound(const Instance& inst) {
+	{
+		std::lock_guard<std::mutex> lock(bounds_mutex);
+		auto it = bounds.find(inst.id());
+		if (it != bounds.end())
+			return it->second;
+	}
+	// computed outside the lock; threads racing on one instance agree anyway
+	std::size_t bound =
+			std::max<std::size_t>(independent_witnesses(inst).size(), 1);
+	remember_cover_lower_bound(inst, bound);
+	return bound;
+}
+
+void remember_cover_lower_bound(const Instance& inst, std::size_t bound) {
+	std::lock_guard<std::mutex> lock(bounds_mutex);
+	bounds[inst.id()] = bound;
+}
+
+} // namespace cgshop2023
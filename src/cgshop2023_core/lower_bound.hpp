@@ -0,0 +1,37 @@
+#pragma once
+
+//
+// Lower bounds on the size of a cover, from points that need distinct polygons.
+//
+
+#include "cpp_instance.hpp"
+#include "int_geometry.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace cgshop2023 {
+
+// Vertices of the instance no two of which can be covered by one convex
+// polygon inside it, since the segment between them leaves the instance
+// (IntBoundary::segment_leaves). Every cover needs a polygon per witness.
+// Found greedily: vertices are tried in the order of how much of a random
+// sample of the nearby vertices they see, so tips of spikes and pockets go
+// first and reflex vertices, which see a lot, go last; a few perturbed orders
+// are tried and the largest set is kept. A candidate is tested against the
+// witnesses nearest to it along a Hilbert curve first. Gives up after about
+// max_checks segment tests, the sampling included, or max_seconds, whichever
+// comes first; the time goes to the lower_bound.compute timer.
+// Empty if the instance has no integer copy (Instance::boundary).
+std::vector<IntPoint>
+independent_witnesses(const Instance& inst, std::size_t max_checks = 2'000'000,
+											double max_seconds = 5);
+
+// The number of independent_witnesses (at least 1), computed once per
+// instance. Thread safe.
+std::size_t cover_lower_bound(const Instance& inst);
+
+// Let cover_lower_bound return bound for inst from now on, e.g. one read from
+// a cache.
+void remember_cover_lower_bound(const Instance& inst, std::size_t bound);
+
+} // namespace cgshop2023
@@ -0,0 +1,97 @@
+#include "profiling.hpp"
+#include <cctype>
+#include <fstream>
+
+namespace cgshop2023::profiling {
+
+bool enabled = false;
+
+void Registry::merge(const Registry& other) {
+	for (const auto& [name, timer] : other.timers) {
+		auto& mine = timers[name];
+		mine.count += timer.count;
+		mine.nanos += timer.nanos;
+	}
+	for (const auto& [name, value] : other.counters)
+		counters[name] += value;
+}
+
+Registry& local() {
+	thread_local Registry registry;
+	return registry;
+}
+
+Registry take() {
+	Registry taken;
+	std::swap(taken, local());
+	return taken;
+}
+
+std::string family(const std::string& name) {
+	size_t end = 0;
+	while (end < name.size() && name[end] != '_' &&
+				 !std::isdigit(static_cast<unsigned char>(name[end])))
+		++end;
+	return name.substr(0, end);
+}
+
+static double ratio(double num, double den) { return den > 0 ? num / den : 0; }
+
+void write_json(std::ostream& output, const std::string& name,
+								const Registry& registry, double wall_seconds) {
+	auto counter = [&](const char* key) -> double {
+		auto it = registry.counters.find(key);
+		return it == registry.counters.end() ? 0 : double(it->second);
+	};
+	output << "{\"instance\": \"" << name << "\", \"family\": \"" << family(name)
+				 << "\", \"wall_seconds\": " << wall_seconds << ",\n";
+	output << "\"timers\": {";
+	bool first = true;
+	for (const auto& [key, timer] : registry.timers) {
+		double seconds = double(timer.nanos) * 1e-9;
+		output << (first ? "\n" : ",\n") << "  \"" << key
+					 << "\": {\"count\": " << timer.count << ", \"seconds\": " << seconds
+					 << ", \"share\": " << ratio(seconds, wall_seconds) << "}";
+		first = false;
+	}
+	output << "},\n\"counters\": {";
+	first = true;
+	for (const auto& [key, value] : registry.counters) {
+		output << (first ? "\n" : ",\n") << "  \"" << key << "\": " << value;
+		first = false;
+	}
+	output << "},\n\"rates\": {";
+	output << "\n  \"removal_attempts_per_second\": "
+				 << ratio(counter("removal.attempts"), wall_seconds);
+	output << ",\n  \"removal_success_rate\": "
+				 << ratio(counter("removal.success"), counter("removal.attempts"));
+	output << ",\n  \"expand_success_rate\": "
+				 << ratio(counter("greedy_expand.accepted"),
+									counter("greedy_expand.calls"));
+	for (const char* stage : {"segment", "containment"}) {
+		std::string key = std::string("greedy_expand.reject.") + stage;
+		output << ",\n  \"expand_reject_" << stage << "_rate\": "
+					 << ratio(counter(key.c_str()), counter("greedy_expand.calls"));
+	}
+	output << ",\n  \"shrinks_per_second\": "
+				 << ratio(counter("shrink.calls"), wall_seconds);
+	output << ",\n  \"normalized_vertices_per_polygon\": "
+				 << ratio(counter("normalize.vertices"), counter("normalize.calls"));
+	output << ",\n  \"normalize_round_success_rate\": "
+				 << ratio(counter("normalize.rounded"),
+									counter("normalize.round_attempts"));
+	output << "\n}}\n";
+}
+
+void write_report(const std::string& directory, const std::string& name,
+									const Registry& registry, double wall_seconds) {
+	std::ofstream ofs(directory + "/" + name + ".metrics.json");
+	if (!ofs) {
+		std::cerr << "Could not write metrics for " << name << " to " << directory
+							<< std::endl;
+		return;
+	}
+	write_json(ofs, name, registry, wall_seconds);
+}
+
+} // namespace cgshop2023::profiling
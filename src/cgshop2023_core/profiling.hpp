@@ -0,0 +1,89 @@
+#pragma once
+
+//
+// Low-overhead per-thread timers and counters, reported per instance.
+//
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+
+namespace cgshop2023::profiling {
+
+struct Timer {
+	std::uint64_t count = 0;
+	std::uint64_t nanos = 0;
+};
+
+// Accumulated timers and counters of one thread (or, after merge, of all the
+// threads that worked on one instance).
+struct Registry {
+	std::map<std::string, Timer, std::less<>> timers;
+	std::map<std::string, std::uint64_t, std::less<>> counters;
+
+	void merge(const Registry& other);
+};
+
+// Collection is off unless enabled (--metrics), in which case a timer costs
+// two clock reads and a map lookup.
+extern bool enabled;
+
+// registry of the calling thread
+Registry& local();
+
+// take (and clear) the calling thread's registry, e.g. before a worker thread
+// exits so its parent can merge it
+Registry take();
+
+inline void count(const char* name, std::uint64_t n = 1) {
+	if (!enabled)
+		return;
+	auto& counters = local().counters;
+	auto it = counters.find(name);
+	if (it == counters.end())
+		it = counters.emplace(name, 0).first;
+	it->second += n;
+}
+
+class ScopedTimer {
+public:
+	explicit ScopedTimer(const char* name) : m_name(name) {
+		if (enabled)
+			m_start = std::chrono::steady_clock::now();
+	}
+	ScopedTimer(const ScopedTimer&) = delete;
+	ScopedTimer& operator=(const ScopedTimer&) = delete;
+	~ScopedTimer() {
+		if (!enabled)
+			return;
+		auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+										 std::chrono::steady_clock::now() - m_start)
+										 .count();
+		auto& timers = local().timers;
+		auto it = timers.find(m_name);
+		if (it == timers.end())
+			it = timers.emplace(m_name, Timer{}).first;
+		it->second.count += 1;
+		it->second.nanos += std::uint64_t(nanos);
+	}
+
+private:
+	const char* m_name;
+	std::chrono::steady_clock::time_point m_start;
+};
+
+// instance family (cheese, ccheese, maze, srpg, fpg-poly, socg, ...)
+std::string family(const std::string& name);
+
+// Write the registry as one JSON object: timers, counters and derived rates
+// (attempts/s, success rates, share of the wall time per timer).
+void write_json(std::ostream& output, const std::string& name,
+								const Registry& registry, double wall_seconds);
+
+// write_json to <directory>/<name>.metrics.json
+void write_report(const std::string& directory, const std::string& name,
+									const Registry& registry, double wall_seconds);
+
+} // namespace cgshop2023::profiling
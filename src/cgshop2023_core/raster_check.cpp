@@ -0,0 +1,227 @@
+#include "raster_check.hpp"
+#include "profiling.hpp"
+#include <CGAL/Bbox_2.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace cgshop2023 {
+
+namespace {
+
+struct Edge {
+	double x0, y0, x1, y1;
+};
+
+// pixel grid over the instance; pixel (r, c) is sampled at its centre
+struct Grid {
+	double xmin, ymin, pixel;
+	long cols, rows;
+
+	// index of the first row (column) whose centre is at or above y (x)
+	[[nodiscard]] long row_at(double y) const {
+		return std::clamp(long(std::ceil((y - ymin) / pixel - 0.5)), 0L, rows);
+	}
+	[[nodiscard]] long col_at(double x) const {
+		return std::clamp(long(std::ceil((x - xmin) / pixel - 0.5)), 0L, cols);
+	}
+	[[nodiscard]] double centre_x(long c) const {
+		return xmin + (double(c) + 0.5) * pixel;
+	}
+	[[nodiscard]] double centre_y(long r) const {
+		return ymin + (double(r) + 0.5) * pixel;
+	}
+};
+
+struct Candidate {
+	double x, y;
+	bool uncovered;
+};
+
+// at most this many candidates per band, and confirmed overall
+constexpr std::size_t MAX_BAND_CANDIDATES = 4;
+constexpr std::size_t MAX_CONFIRMED = 16;
+
+} // namespace
+
+// Call f(row, x) for every row in [r0, r1) whose centre line e crosses, at
+// the crossing. Rows are counted half-open in y, so the two edges at a vertex
+// on a centre line cross it once together (or not at all).
+template <typename F>
+static void for_crossings(const Edge& e, const Grid& grid, long r0, long r1,
+													F&& f) {
+	if (e.y0 == e.y1)
+		return;
+	long first = std::max(grid.row_at(std::min(e.y0, e.y1)), r0);
+	long last = std::min(grid.row_at(std::max(e.y0, e.y1)), r1);
+	double slope = (e.x1 - e.x0) / (e.y1 - e.y0);
+	for (long r = first; r < last; ++r)
+		f(r, e.x0 + (grid.centre_y(r) - e.y0) * slope);
+}
+
+static void append_edges(const SimplePolygon& ring, std::vector<Edge>& out) {
+	for (auto e = ring.edges_begin(); e != ring.edges_end(); ++e)
+		out.push_back(Edge{CGAL::to_double(e->source().x()),
+											 CGAL::to_double(e->source().y()),
+											 CGAL::to_double(e->target().x()),
+											 CGAL::to_double(e->target().y())});
+}
+
+// Scan-convert rows [r0, r1): a difference array per row for the instance
+// (even-odd over its crossings) and for the polygons (one span per convex
+// polygon), then compare the two at every centre.
+static void scan_band(const Grid& grid, long r0, long r1,
+											const std::vector<Edge>& boundary,
+											const std::vector<std::vector<Edge>>& polygons,
+											const std::vector<CGAL::Bbox_2>& boxes,
+											std::vector<Candidate>& out) {
+	std::size_t stride = std::size_t(grid.cols) + 1;
+	std::size_t band = std::size_t(r1 - r0);
+	std::vector<int> inside(band * stride, 0), covered(band * stride, 0);
+	auto mark = [&](std::vector<int>& cells, long r, double a, double b) {
+		long ca = grid.col_at(a), cb = grid.col_at(b);
+		if (ca >= cb)
+			return;
+		++cells[std::size_t(r - r0) * stride + std::size_t(ca)];
+		--cells[std::size_t(r - r0) * stride + std::size_t(cb)];
+	};
+
+	std::vector<std::vector<double>> crossings(band);
+	for (const Edge& e : boundary)
+		for_crossings(e, grid, r0, r1, [&](long r, double x) {
+			crossings[std::size_t(r - r0)].push_back(x);
+		});
+	for (long r = r0; r < r1; ++r) {
+		auto& xs = crossings[std::size_t(r - r0)];
+		std::sort(xs.begin(), xs.end());
+		for (std::size_t k = 0; k + 1 < xs.size(); k += 2)
+			mark(inside, r, xs[k], xs[k + 1]);
+	}
+
+	std::vector<double> lo, hi;
+	for (std::size_t i = 0; i < polygons.size(); ++i) {
+		long pr0 = std::max(grid.row_at(boxes[i].ymin()), r0);
+		long pr1 = std::min(grid.row_at(boxes[i].ymax()), r1);
+		if (pr0 >= pr1)
+			continue;
+		lo.assign(std::size_t(pr1 - pr0), std::numeric_limits<double>::infinity());
+		hi.assign(lo.size(), -std::numeric_limits<double>::infinity());
+		for (const Edge& e : polygons[i])
+			for_crossings(e, grid, pr0, pr1, [&](long r, double x) {
+				std::size_t k = std::size_t(r - pr0);
+				lo[k] = std::min(lo[k], x);
+				hi[k] = std::max(hi[k], x);
+			});
+		for (long r = pr0; r < pr1; ++r)
+			if (lo[std::size_t(r - pr0)] <= hi[std::size_t(r - pr0)])
+				mark(covered, r, lo[std::size_t(r - pr0)], hi[std::size_t(r - pr0)]);
+	}
+
+	for (long r = r0; r < r1 && out.size() < MAX_BAND_CANDIDATES; ++r) {
+		const int* in_row = &inside[std::size_t(r - r0) * stride];
+		const int* cov_row = &covered[std::size_t(r - r0) * stride];
+		int in = 0, cov = 0;
+		for (long c = 0; c < grid.cols && out.size() < MAX_BAND_CANDIDATES; ++c) {
+			in += in_row[c];
+			cov += cov_row[c];
+			if ((in > 0) != (cov > 0))
+				out.push_back(Candidate{grid.centre_x(c), grid.centre_y(r), in > 0});
+		}
+	}
+}
+
+static bool strictly_inside(const Polygon& poly, const Point& p) {
+	if (poly.outer_boundary().bounded_side(p) != CGAL::ON_BOUNDED_SIDE)
+		return false;
+	return std::all_of(poly.holes_begin(), poly.holes_end(), [&](const auto& h) {
+		return h.bounded_side(p) == CGAL::ON_UNBOUNDED_SIDE;
+	});
+}
+
+static bool strictly_outside(const Polygon& poly, const Point& p) {
+	if (poly.outer_boundary().bounded_side(p) == CGAL::ON_UNBOUNDED_SIDE)
+		return true;
+	return std::any_of(poly.holes_begin(), poly.holes_end(), [&](const auto& h) {
+		return h.bounded_side(p) == CGAL::ON_BOUNDED_SIDE;
+	});
+}
+
+std::optional<RasterWitness> find_raster_witness(const Instance& inst,
+																								 const Solution& sol,
+																								 std::size_t resolution,
+																								 std::size_t threads) {
+	profiling::ScopedTimer timer("verify.raster");
+	CGAL::Bbox_2 box = inst.polygon().outer_boundary().bbox();
+	double extent =
+			std::max(box.xmax() - box.xmin(), box.ymax() - box.ymin());
+	if (!(extent > 0) || resolution == 0)
+		return std::nullopt;
+	Grid grid;
+	grid.xmin = box.xmin();
+	grid.ymin = box.ymin();
+	grid.pixel = extent / double(resolution);
+	grid.cols =
+			std::max(1L, long(std::ceil((box.xmax() - box.xmin()) / grid.pixel)));
+	grid.rows =
+			std::max(1L, long(std::ceil((box.ymax() - box.ymin()) / grid.pixel)));
+
+	// double copies of everything, so the bands never touch the lazy kernel
+	std::vector<Edge> boundary;
+	append_edges(inst.polygon().outer_boundary(), boundary);
+	for (const auto& hole : inst.polygon().holes())
+		append_edges(hole, boundary);
+	const auto& polys = sol.polygons();
+	std::vector<std::vector<Edge>> polygons(polys.size());
+	std::vector<CGAL::Bbox_2> boxes;
+	for (std::size_t i = 0; i < polys.size(); ++i) {
+		append_edges(polys[i], polygons[i]);
+		boxes.push_back(polys[i].bbox());
+	}
+
+	std::size_t bands =
+			std::clamp<std::size_t>(threads, 1, std::size_t(grid.rows));
+	std::vector<std::vector<Candidate>> found(bands);
+	auto run = [&](std::size_t b) {
+		long r0 = long(std::size_t(grid.rows) * b / bands);
+		long r1 = long(std::size_t(grid.rows) * (b + 1) / bands);
+		scan_band(grid, r0, r1, boundary, polygons, boxes, found[b]);
+	};
+	std::vector<std::thread> pool;
+	for (std::size_t b = 1; b < bands; ++b)
+		pool.emplace_back(run, b);
+	run(0);
+	for (auto& t : pool)
+		t.join();
+
+	// the raster is only approximate (centres on or next to an edge can come
+	// out either way), so every candidate is checked exactly
+	std::size_t confirmed = 0;
+	for (const auto& candidates : found)
+		for (const Candidate& cand : candidates) {
+			if (confirmed++ == MAX_CONFIRMED)
+				return std::nullopt;
+			profiling::count("verify.raster.candidates");
+			Point p(cand.x, cand.y);
+			CGAL::Bbox_2 at = p.bbox();
+			if (cand.uncovered) {
+				if (!strictly_inside(inst.polygon(), p))
+					continue;
+				bool in_some = false;
+				for (std::size_t i = 0; i < polys.size() && !in_some; ++i)
+					in_some = CGAL::do_overlap(at, boxes[i]) &&
+										polys[i].bounded_side(p) != CGAL::ON_UNBOUNDED_SIDE;
+				if (!in_some)
+					return RasterWitness{p, true};
+			} else if (strictly_outside(inst.polygon(), p)) {
+				for (std::size_t i = 0; i < polys.size(); ++i)
+					if (CGAL::do_overlap(at, boxes[i]) &&
+							polys[i].bounded_side(p) == CGAL::ON_BOUNDED_SIDE)
+						return RasterWitness{p, false, i};
+			}
+		}
+	return std::nullopt;
+}
+
+} // namespace cgshop2023
@@ -0,0 +1,33 @@
+#pragma once
+
+//
+// Conservative raster pre-check of a cover, run before the exact verifier.
+//
+
+#include "cpp_instance.hpp"
+#include <cstddef>
+#include <optional>
+
+namespace cgshop2023 {
+
+// A point that proves a cover invalid: it lies inside the instance but in no
+// polygon, or strictly inside polygon `polygon` but outside the instance.
+struct RasterWitness {
+	Point point;
+	bool uncovered;
+	std::size_t polygon = 0;
+};
+
+// Scan-convert the instance and the (convex) polygons of sol at the pixel
+// centres of a grid of about resolution pixels along the longer side of the
+// instance, in bands of rows on up to threads threads. Pixel centres that
+// look uncovered inside the instance, or covered outside of it, are
+// candidates; the first few are confirmed with exact predicates. A witness
+// is only returned if it is confirmed, so no witness does not mean the cover
+// is valid.
+std::optional<RasterWitness> find_raster_witness(const Instance& inst,
+																								 const Solution& sol,
+																								 std::size_t resolution = 1024,
+																								 std::size_t threads = 1);
+
+} // namespace cgshop2023
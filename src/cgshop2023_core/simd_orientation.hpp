@@ -0,0 +1,53 @@
+#pragma once
+
+//
+// Filtered orientation tests in double precision, vectorized with AVX.
+//
+
+#include <CGAL/Exact_predicates_exact_constructions_kernel.h>
+#include <CGAL/Point_2.h>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace cgshop2023 {
+
+// Shewchuk's error bound for the orientation determinant of exact double
+// inputs: a computed determinant larger than this times the sum of the
+// magnitudes of its two products has the sign of the exact one.
+constexpr double ORIENTATION_ERRBOUND = (3.0 + 16.0 * 0x1p-53) * 0x1p-53;
+
+// Results of the filtered tests: the certain sign of the orientation of
+// (a, b, c), or 0 if the filter cannot decide (which includes every collinear
+// triple), in which case the caller has to ask the exact kernel.
+inline std::int8_t orientation_filtered(double ax, double ay, double bx,
+																				double by, double cx, double cy) {
+	double left = (ax - cx) * (by - cy);
+	double right = (ay - cy) * (bx - cx);
+	double det = left - right;
+	double bound = ORIENTATION_ERRBOUND * (std::abs(left) + std::abs(right));
+	return std::int8_t((det > bound) - (-det > bound));
+}
+
+// orientation of (a, b, (px[i], py[i])) for i < n
+void orientation_batch(double ax, double ay, double bx, double by,
+											 const double* px, const double* py, std::size_t n,
+											 std::int8_t* out);
+
+// orientation of ((ax[i], ay[i]), (bx[i], by[i]), (cx[i], cy[i])) for i < n
+void orientation_batch(const double* ax, const double* ay, const double* bx,
+											 const double* by, const double* cx, const double* cy,
+											 std::size_t n, std::int8_t* out);
+
+// The coordinates of p, if they are exactly representable as doubles (read
+// off the interval approximation, so the lazy kernel is never forced).
+inline bool to_exact_double(const CGAL::Point_2<CGAL::Epeck>& p, double& x,
+														double& y) {
+	auto ix = CGAL::to_interval(p.x());
+	auto iy = CGAL::to_interval(p.y());
+	x = ix.first;
+	y = iy.first;
+	return ix.first == ix.second && iy.first == iy.second;
+}
+
+} // namespace cgshop2023
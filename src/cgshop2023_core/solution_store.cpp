@@ -0,0 +1,103 @@
+#include "solution_store.hpp"
+#include "profiling.hpp"
+#include "verify.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <sys/file.h>
+#include <unistd.h>
+
+namespace cgshop2023 {
+
+namespace {
+
+// exclusive advisory lock on a file, held for the lifetime of the object
+class FileLock {
+public:
+	explicit FileLock(const std::string& path)
+			: m_fd(open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)) {
+		if (m_fd < 0)
+			throw std::runtime_error("could not open " + path + ": " +
+															 std::strerror(errno));
+		while (flock(m_fd, LOCK_EX) != 0) {
+			if (errno == EINTR)
+				continue;
+			int error = errno;
+			close(m_fd);
+			throw std::runtime_error("could not lock " + path + ": " +
+															 std::strerror(error));
+		}
+	}
+	FileLock(const FileLock&) = delete;
+	FileLock& operator=(const FileLock&) = delete;
+	~FileLock() { close(m_fd); } // releases the lock
+
+private:
+	int m_fd;
+};
+
+} // namespace
+
+SolutionStore::Result SolutionStore::commit(const Instance& inst,
+																						const std::string& name,
+																						Solution& sol) const {
+	profiling::ScopedTimer timer("store.commit");
+	SolutionVerifier verifier(&inst, &sol);
+	if (!verifier.verify()) {
+		std::cerr << "Warning: Tried to save invalid solution for " << name
+							<< std::endl;
+		return Result::Invalid;
+	}
+
+	std::optional<std::size_t> previous;
+	{
+		FileLock lock(out_file_full(name) + ".lock");
+		profiling::count("store.locked");
+		if (solution_exists(name)) {
+			std::optional<Solution> old;
+			try {
+				old = Solution::read_file(name);
+			} catch (const std::exception& e) {
+				std::cerr << "Replacing unreadable solution of " << name << ": "
+									<< e.what() << std::endl;
+			}
+			if (old && old->size() <= sol.size()) {
+				SolutionVerifier old_verifier(&inst, &*old);
+				if (old_verifier.verify()) {
+					std::cerr << "Did not see improvement to " << name
+										<< " (previous:" << old->size() << ", new:" << sol.size()
+										<< ")" << std::endl;
+					return Result::NotBetter;
+				}
+			}
+			if (old)
+				previous = old->size();
+		}
+		sol.write_file(name);
+	}
+
+	if (previous)
+		std::cerr << "Found solution improvement for " << name << ": "
+							<< *previous << "->" << sol.size() << std::endl;
+	else
+		std::cerr << "No existing saved solution for " << name
+							<< ". This one is valid, writing it (size=" << sol.size()
+							<< ")." << std::endl;
+	if (!m_history_dir.empty()) {
+		auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+											std::chrono::system_clock::now().time_since_epoch())
+											.count();
+		sol.write_to(m_history_dir + "/" + remove_ext(name) + "." +
+										 std::to_string(sol.size()) + "." +
+										 std::to_string(millis) + ".solution.json",
+								 name);
+	}
+	return Result::Written;
+}
+
+} // namespace cgshop2023
@@ -0,0 +1,42 @@
+#pragma once
+
+//
+// Saved solutions shared by concurrent processes.
+//
+
+#include "cpp_instance.hpp"
+#include <string>
+
+namespace cgshop2023 {
+
+// The solutions/ directory as a store that any number of processes (also on
+// several machines, over shared storage) can improve at the same time. The
+// saved solution of an instance only changes under an advisory lock on its
+// lock file (flock on solutions/<name>.solution.json.lock), by an atomic
+// rename, and only to one with fewer polygons than the one found under the
+// lock, so no process overwrites a better result of another. Optionally,
+// every improvement is also kept in a history directory as
+// <name>.<polygons>.<milliseconds since epoch>.solution.json.
+class SolutionStore {
+public:
+	explicit SolutionStore(std::string history_dir = "")
+			: m_history_dir(std::move(history_dir)) {}
+
+	enum class Result { Written, NotBetter, Invalid };
+
+	// Verify sol (without holding the lock), then replace the saved solution
+	// of name by it if that has more polygons (compare and swap on the count).
+	// The saved solution itself is only verified if it is not larger, to
+	// decide whether a broken file may be replaced.
+	Result commit(const Instance& inst, const std::string& name,
+								Solution& sol) const;
+
+	[[nodiscard]] const std::string& history_dir() const {
+		return m_history_dir;
+	}
+
+private:
+	std::string m_history_dir;
+};
+
+} // namespace cgshop2023
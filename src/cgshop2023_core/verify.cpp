@@ -1,6 +1,10 @@
 #include "./fmt_point.h"
+#include "profiling.hpp"
+#include "raster_check.hpp"
+#include "simd_orientation.hpp"
 #include "verify.hpp"
 #include <CGAL/Boolean_set_operations_2.h>
+#include <algorithm>
 #include <fmt/core.h>
 #include <fmt/format.h>
 #include <functional>
@@ -9,8 +13,38 @@
 
 namespace cgshop2023 {
 
+// Does every turn of the simple polygon poly certainly go the same way? Then
+// it is (strictly) convex; otherwise the exact test has to decide.
+static bool certainly_convex(const SimplePolygon& poly) {
+	thread_local std::vector<double> x, y, ax, ay, bx, by;
+	thread_local std::vector<std::int8_t> turns;
+	std::size_t n = poly.size();
+	if (n < 3)
+		return false;
+	x.resize(n);
+	y.resize(n);
+	for (std::size_t k = 0; k < n; ++k)
+		if (!to_exact_double(poly.vertex(k), x[k], y[k]))
+			return false;
+	// turn at vertex k + 1: (v[k], v[k + 1], v[k + 2])
+	ax = x;
+	ay = y;
+	bx.assign(x.begin() + 1, x.end());
+	bx.push_back(x[0]);
+	by.assign(y.begin() + 1, y.end());
+	by.push_back(y[0]);
+	std::rotate(x.begin(), x.begin() + 2, x.end());
+	std::rotate(y.begin(), y.begin() + 2, y.end());
+	turns.resize(n);
+	orientation_batch(ax.data(), ay.data(), bx.data(), by.data(), x.data(),
+										y.data(), n, turns.data());
+	return turns[0] != 0 && std::all_of(turns.begin(), turns.end(),
+																			[&](auto t) { return t == turns[0]; });
+}
+
 // check that all polygons of the solution are convex
 bool SolutionVerifier::p_verify_convexity() {
+	profiling::ScopedTimer timer("verify.convexity");
 	std::size_t idx = 0;
 	for (const SimplePolygon& poly : solution().polygons()) {
 		if (!poly.is_simple()) {
@@ -24,7 +58,9 @@ bool SolutionVerifier::p_verify_convexity() {
 			m_error = fmt::format("polygon {} has a zero length edge", idx);
 			return false;
 		}
-		if (!poly.is_convex()) {
+		if (certainly_convex(poly))
+			profiling::count("verify.convexity.filtered");
+		else if (!poly.is_convex()) {
 			m_error = fmt::format("polygon {} is not convex", idx);
 			return false;
 		}
@@ -33,7 +69,58 @@ bool SolutionVerifier::p_verify_convexity() {
 	return true;
 }
 
+// Reject polygons that leave the instance before building the union. Only
+// decided for polygons with integer vertices (on the integer boundary), the
+// others are left to the coverage checks.
+bool SolutionVerifier::p_verify_inside() {
+	const IntBoundary& boundary = instance().boundary();
+	m_all_inside = false;
+	if (!boundary.valid())
+		return true;
+	profiling::ScopedTimer timer("verify.inside");
+	std::vector<IntPoint> int_poly;
+	bool all_inside = true;
+	std::size_t idx = 0;
+	for (const SimplePolygon& poly : solution().polygons()) {
+		int_poly.clear();
+		bool integral = true;
+		for (auto it = poly.vertices_begin(); integral && it != poly.vertices_end();
+				 ++it) {
+			IntPoint q;
+			integral = to_int_point(*it, q);
+			int_poly.push_back(q);
+		}
+		if (integral && !boundary.contains_convex(int_poly)) {
+			m_error = fmt::format("polygon {} is not inside the instance", idx);
+			return false;
+		}
+		all_inside = all_inside && integral;
+		++idx;
+	}
+	m_all_inside = all_inside;
+	return true;
+}
+
+// Cheap rejection of broken covers before the union: a raster of pixel
+// centres finds candidate points that are uncovered or outside the instance,
+// and one that is confirmed exactly decides.
+bool SolutionVerifier::p_verify_raster() {
+	auto witness =
+			find_raster_witness(instance(), solution(), 1024, m_threads);
+	if (!witness)
+		return true;
+	profiling::count("verify.raster.rejected");
+	if (witness->uncovered)
+		m_error = fmt::format("the polygons leave point {} uncovered",
+													witness->point);
+	else
+		m_error = fmt::format("polygon {} is not inside the instance at point {}",
+													witness->polygon, witness->point);
+	return false;
+}
+
 std::optional<Polygon> SolutionVerifier::compute_coverage() {
+	profiling::ScopedTimer timer("verify.union");
 	auto union_results = solution().coverage();
 	if (union_results.empty()) {
 		m_error = fmt::format("polygons have empty union");
@@ -57,17 +144,19 @@ Kernel::FT area(const Polygon& polygon) {
 
 // check that the entire instance is covered
 bool SolutionVerifier::p_verify_coverage(const Polygon& coverage) {
+	profiling::ScopedTimer timer("verify.difference");
 	const Polygon& ipoly = instance().polygon();
 	std::vector<Polygon> diff_results;
 	CGAL::difference(ipoly, coverage, std::back_inserter(diff_results));
 	return std::all_of(
 			diff_results.begin(), diff_results.end(), [&](const auto& poly) {
 				const auto& ob = poly.outer_boundary();
-				if (area(poly) > 0) {
+				Kernel::FT uncovered = area(poly);
+				if (uncovered > 0) {
 					m_error =
 							fmt::format("the union of the polygons leaves uncovered some "
 													"area of volume {} at or near point {}",
-													CGAL::to_double(area(poly)), *ob.vertices_begin());
+													CGAL::to_double(uncovered), *ob.vertices_begin());
 					return false;
 				}
 				return true;
@@ -75,15 +164,29 @@ bool SolutionVerifier::p_verify_coverage(const Polygon& coverage) {
 }
 
 bool SolutionVerifier::verify() {
+	profiling::ScopedTimer timer("verify");
 	if (!p_verify_convexity())
 		return false;
+	// the raster finds most broken covers for less than the exact checks
+	if (!p_verify_raster())
+		return false;
+	if (!p_verify_inside())
+		return false;
+	if (!check_total_area())
+		return false;
 	auto coverage = compute_coverage();
 	if (coverage) {
-		if (!check_coverage_area_size(*coverage))
+		Kernel::FT covered = area(*coverage);
+		if (!check_coverage_area_size(covered))
 			return false;
+		// a union inside the instance with the same area leaves nothing
+		// uncovered, so the difference is only needed if some polygon could not
+		// be checked on the integer boundary
+		if (m_all_inside && covered == instance().area())
+			return true;
 		if (!p_verify_coverage(*coverage))
 			return false;
-		if (area(*coverage) != area(instance().polygon())) {
+		if (covered != instance().area()) {
 			m_error = "The area doesn't fit, but somehow no rule has been triggered";
 			return false;
 		}
@@ -92,9 +195,20 @@ bool SolutionVerifier::verify() {
 	return false;
 }
 
-bool SolutionVerifier::check_coverage_area_size(const Polygon& coverage) {
-	const Polygon& ipoly = instance().polygon();
-	if (area(coverage) > area(ipoly)) {
+// the polygons cannot cover more area than their areas add up to
+bool SolutionVerifier::check_total_area() {
+	profiling::ScopedTimer timer("verify.area");
+	if (solution().total_area() < instance().area()) {
+		m_error =
+				fmt::format("the polygons have less total area than the instance");
+		return false;
+	}
+	return true;
+}
+
+bool SolutionVerifier::check_coverage_area_size(const Kernel::FT& covered) {
+	profiling::ScopedTimer timer("verify.area");
+	if (covered > instance().area()) {
 		m_error = fmt::format("the solution covers more area than the instance.");
 		return false;
 	}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "cpp_instance.hpp"
+#include <cstddef>
 #include <optional>
 #include <string>
 
@@ -8,8 +9,12 @@ namespace cgshop2023 {
 
 class SolutionVerifier {
 public:
-	SolutionVerifier(const Instance* instance, const Solution* solution) noexcept
-			: m_error(std::nullopt), m_instance(instance), m_solution(solution) {}
+	// threads is the number of threads the raster pre-check may use; callers
+	// that already verify in parallel keep the default of one
+	SolutionVerifier(const Instance* instance, const Solution* solution,
+									 std::size_t threads = 1) noexcept
+			: m_error(std::nullopt), m_instance(instance), m_solution(solution),
+				m_threads(threads) {}
 
 	const Solution& solution() const noexcept { return *m_solution; }
 	const Instance& instance() const noexcept { return *m_instance; }
@@ -21,13 +26,19 @@ public:
 
 private:
 	bool p_verify_convexity();
+	bool p_verify_inside();
+	bool p_verify_raster();
 	bool p_verify_coverage(const Polygon& coverage);
 	std::optional<Polygon> compute_coverage();
-	bool check_coverage_area_size(const Polygon& coverage);
+	bool check_total_area();
+	bool check_coverage_area_size(const Kernel::FT& covered);
 
 	std::optional<std::string> m_error;
+	// set by p_verify_inside if every polygon was shown to lie in the instance
+	bool m_all_inside = false;
 	const Instance* m_instance;
 	const Solution* m_solution;
+	std::size_t m_threads;
 };
 
 } // namespace cgshop2023
@@ -0,0 +1,107 @@
+#include "committer.hpp"
+#include <exception>
+#include <iostream>
+
+SolutionCommitter::SolutionCommitter(SolutionStore store)
+		: m_store(std::move(store)), m_thread([this]() { run(); }) {}
+
+SolutionCommitter::~SolutionCommitter() {
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	m_thread.join();
+}
+
+void SolutionCommitter::submit(shared_ptr<const Instance> inst,
+															 const string& name, Solution sol,
+															 function<void(bool)> on_saved) {
+	unique_lock<mutex> lock(m_mutex);
+	++m_stats.submitted;
+	auto written = m_written.find(name);
+	if (written != m_written.end() && sol.size() >= written->second) {
+		++m_stats.coalesced;
+		lock.unlock();
+		if (on_saved)
+			on_saved(true);
+		return;
+	}
+	auto pending = m_pending.find(name);
+	if (pending != m_pending.end()) {
+		++m_stats.coalesced;
+		Pending& job = pending->second;
+		if (sol.size() <= job.sol.size()) {
+			job.inst = std::move(inst);
+			job.sol = std::move(sol);
+		}
+		if (on_saved)
+			job.on_saved.push_back(std::move(on_saved));
+		return;
+	}
+	Pending job{std::move(inst), std::move(sol), {}};
+	if (on_saved)
+		job.on_saved.push_back(std::move(on_saved));
+	m_pending.emplace(name, std::move(job));
+	m_order.push_back(name);
+	m_wake.notify_one();
+}
+
+void SolutionCommitter::flush() {
+	unique_lock<mutex> lock(m_mutex);
+	m_idle.wait(lock, [&]() { return m_order.empty() && !m_busy; });
+}
+
+SolutionCommitter::Stats SolutionCommitter::stats() const {
+	lock_guard<mutex> lock(m_mutex);
+	return m_stats;
+}
+
+optional<size_t> SolutionCommitter::written_size(const string& name) const {
+	lock_guard<mutex> lock(m_mutex);
+	auto it = m_written.find(name);
+	if (it == m_written.end())
+		return nullopt;
+	return it->second;
+}
+
+void SolutionCommitter::run() {
+	unique_lock<mutex> lock(m_mutex);
+	while (true) {
+		m_wake.wait(lock, [&]() { return m_stop || !m_order.empty(); });
+		if (m_order.empty())
+			break;
+		string name = std::move(m_order.front());
+		m_order.pop_front();
+		auto node = m_pending.extract(name);
+		Pending& job = node.mapped();
+		m_busy = true;
+		lock.unlock();
+
+		auto result = SolutionStore::Result::Invalid;
+		bool failed = false;
+		try {
+			result = m_store.commit(*job.inst, name, job.sol);
+		} catch (const exception& e) {
+			cerr << "Could not save solution for " << name << ": " << e.what()
+					 << endl;
+			failed = true;
+		}
+		bool written = !failed && result == SolutionStore::Result::Written;
+
+		bool saved = !failed && result != SolutionStore::Result::Invalid;
+		for (auto& on_saved : job.on_saved)
+			on_saved(saved);
+
+		lock.lock();
+		m_busy = false;
+		if (written) {
+			++m_stats.written;
+			m_written[name] = job.sol.size();
+		} else {
+			++m_stats.rejected;
+		}
+		if (m_order.empty())
+			m_idle.notify_all();
+	}
+}
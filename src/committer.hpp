@@ -0,0 +1,76 @@
+#pragma once
+
+#include "cgshop2023_core/cpp_instance.hpp"
+#include "cgshop2023_core/solution_store.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+using namespace cgshop2023;
+using namespace std;
+
+// Saves improved covers off the search threads. submit() only queues the
+// snapshot; a background thread commits it to the solution store, which
+// verifies it and replaces the saved solution if it is smaller. Snapshots of
+// one instance that wait together are coalesced to the latest smallest one,
+// and covers that are not smaller than one this committer already wrote are
+// dropped before any verification (the store only ever gets better).
+class SolutionCommitter {
+public:
+	explicit SolutionCommitter(SolutionStore store = SolutionStore());
+	SolutionCommitter(const SolutionCommitter&) = delete;
+	SolutionCommitter& operator=(const SolutionCommitter&) = delete;
+	// commits everything still pending
+	~SolutionCommitter();
+
+	// inst and sol are used on the committer thread, so they must not share
+	// lazy kernel objects with anything still in use elsewhere (deep copies).
+	// on_saved, if given, is called once the cover has been dealt with, on the
+	// committer thread (or right away if it is dropped): true if the saved
+	// solution of name is now at least as small (it was written, or the store
+	// already had one as good), false if it was invalid or could not be written.
+	void submit(shared_ptr<const Instance> inst, const string& name,
+							Solution sol, function<void(bool)> on_saved = nullptr);
+
+	// wait until everything submitted so far has been committed
+	void flush();
+
+	struct Stats {
+		size_t submitted = 0;
+		size_t coalesced = 0; // superseded while waiting, or not smaller
+		size_t written = 0;
+		size_t rejected = 0; // invalid, or not better than the saved solution
+	};
+	[[nodiscard]] Stats stats() const;
+
+	// size of the last cover of name this committer has written, if any
+	[[nodiscard]] optional<size_t> written_size(const string& name) const;
+
+private:
+	struct Pending {
+		shared_ptr<const Instance> inst;
+		Solution sol;
+		// of every cover coalesced into this one
+		vector<function<void(bool)>> on_saved;
+	};
+
+	void run();
+
+	mutable mutex m_mutex;
+	condition_variable m_wake, m_idle;
+	map<string, Pending> m_pending;
+	deque<string> m_order;
+	map<string, size_t> m_written;
+	bool m_busy = false;
+	bool m_stop = false;
+	Stats m_stats;
+	SolutionStore m_store;
+	thread m_thread; // last, so it starts after everything it uses
+};
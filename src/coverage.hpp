@@ -0,0 +1,128 @@
+#pragma once
+
+#include "cgshop2023_core/cpp_instance.hpp"
+#include <CGAL/Bbox_2.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace cgshop2023;
+using namespace std;
+
+// Uniform grid over the bounding boxes of the polygons in a cover. It is kept
+// in sync with the cover as single polygons are replaced or removed, so
+// finding the polygons that may overlap a given one only touches the grid
+// cells around it instead of the whole solution.
+class CoverageIndex {
+public:
+	CoverageIndex(const Instance& inst, const vector<SimplePolygon>& polys) {
+		m_extent = inst.polygon().outer_boundary().bbox();
+		size_t side = size_t(ceil(sqrt(double(max<size_t>(polys.size(), 1)))));
+		m_nx = m_ny = min<size_t>(max<size_t>(side, 1), 1024);
+		m_cell_w = max((m_extent.xmax() - m_extent.xmin()) / m_nx, 1e-9);
+		m_cell_h = max((m_extent.ymax() - m_extent.ymin()) / m_ny, 1e-9);
+		m_cells.resize(m_nx * m_ny);
+		for (size_t i = 0; i < polys.size(); ++i) {
+			m_boxes.push_back(polys[i].bbox());
+			m_stamp.push_back(0);
+			insert_cells(i);
+		}
+	}
+
+	[[nodiscard]] size_t size() const { return m_boxes.size(); }
+
+	// polygon i of the cover has been replaced by poly
+	void update(size_t i, const SimplePolygon& poly) {
+		erase_cells(i);
+		m_boxes[i] = poly.bbox();
+		insert_cells(i);
+	}
+
+	// poly has been appended to the cover
+	void push_back(const SimplePolygon& poly) {
+		m_boxes.push_back(poly.bbox());
+		m_stamp.push_back(0);
+		insert_cells(m_boxes.size() - 1);
+	}
+
+	// polygon i has been removed by swapping it with the last polygon and
+	// popping, as done by remove_polygon
+	void swap_remove(size_t i) {
+		size_t last = m_boxes.size() - 1;
+		erase_cells(i);
+		if (i != last) {
+			for_cells(m_boxes[last], [&](vector<size_t>& cell) {
+				replace(cell.begin(), cell.end(), last, i);
+			});
+			m_boxes[i] = m_boxes[last];
+		}
+		m_boxes.pop_back();
+		m_stamp.pop_back();
+	}
+
+	// indices of all polygons (other than skip) whose bounding box meets box
+	[[nodiscard]] vector<size_t> overlapping(const CGAL::Bbox_2& box,
+																					 size_t skip = size_t(-1)) const {
+		vector<size_t> result;
+		++m_query;
+		for_cells(box, [&](const vector<size_t>& cell) {
+			for (size_t j : cell) {
+				if (j == skip || m_stamp[j] == m_query)
+					continue;
+				m_stamp[j] = m_query;
+				if (CGAL::do_overlap(box, m_boxes[j]))
+					result.push_back(j);
+			}
+		});
+		return result;
+	}
+
+	[[nodiscard]] vector<size_t> overlapping(size_t i) const {
+		return overlapping(m_boxes[i], i);
+	}
+
+private:
+	size_t cell_x(double x) const {
+		double c = floor((x - m_extent.xmin()) / m_cell_w);
+		return size_t(clamp(c, 0.0, double(m_nx - 1)));
+	}
+
+	size_t cell_y(double y) const {
+		double c = floor((y - m_extent.ymin()) / m_cell_h);
+		return size_t(clamp(c, 0.0, double(m_ny - 1)));
+	}
+
+	template <typename F> void for_cells(const CGAL::Bbox_2& box, F f) const {
+		for (size_t y = cell_y(box.ymin()); y <= cell_y(box.ymax()); ++y)
+			for (size_t x = cell_x(box.xmin()); x <= cell_x(box.xmax()); ++x)
+				f(m_cells[y * m_nx + x]);
+	}
+
+	template <typename F> void for_cells(const CGAL::Bbox_2& box, F f) {
+		for (size_t y = cell_y(box.ymin()); y <= cell_y(box.ymax()); ++y)
+			for (size_t x = cell_x(box.xmin()); x <= cell_x(box.xmax()); ++x)
+				f(m_cells[y * m_nx + x]);
+	}
+
+	void insert_cells(size_t i) {
+		for_cells(m_boxes[i], [&](vector<size_t>& cell) { cell.push_back(i); });
+	}
+
+	void erase_cells(size_t i) {
+		for_cells(m_boxes[i], [&](vector<size_t>& cell) {
+			auto it = find(cell.begin(), cell.end(), i);
+			if (it != cell.end()) {
+				*it = cell.back();
+				cell.pop_back();
+			}
+		});
+	}
+
+	CGAL::Bbox_2 m_extent;
+	size_t m_nx, m_ny;
+	double m_cell_w, m_cell_h;
+	vector<vector<size_t>> m_cells;
+	vector<CGAL::Bbox_2> m_boxes;
+	mutable vector<unsigned> m_stamp;
+	mutable unsigned m_query = 0;
+};
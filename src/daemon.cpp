@@ -0,0 +1,246 @@
+#include "daemon.hpp"
+#include "annealing.hpp"
+#include "cgshop2023_core/cpp_instance.hpp"
+#include "cgshop2023_core/lower_bound.hpp"
+#include "cgshop2023_core/verify.hpp"
+#include "committer.hpp"
+#include "globals.hpp"
+#include "localsearch.hpp"
+#include "portfolio.hpp"
+#include "triangulation.hpp"
+#include <chrono>
+#include <list>
+#include <sstream>
+#include <unordered_map>
+
+using namespace cgshop2023;
+using namespace std;
+
+// Search configuration of a single daemon job, given as trailing tokens of an
+// improve command, e.g. "improve maze_74_50_05_00 30 anneal lahc=500".
+struct JobConfig {
+	bool annealing = false;
+	size_t history_length = 0;
+	size_t shrink_rounds = 0;
+	size_t replacement_choices = 0;
+	size_t portfolio = 0;
+
+	static JobConfig parse(istream& tokens) {
+		JobConfig config;
+		string tok;
+		while (tokens >> tok) {
+			size_t eq = tok.find('=');
+			string key = tok.substr(0, eq);
+			size_t value = eq == string::npos ? 0 : stoul(tok.substr(eq + 1));
+			if (key == "anneal")
+				config.annealing = true;
+			else if (key == "lahc") {
+				config.annealing = true;
+				config.history_length = value;
+			} else if (key == "shrink")
+				config.shrink_rounds = value;
+			else if (key == "choices")
+				config.replacement_choices = value;
+			else if (key == "portfolio")
+				config.portfolio = value;
+			else
+				cerr << "daemon: unknown job option " << tok << endl;
+		}
+		return config;
+	}
+};
+
+// Parsed instances and their current best covers, kept in memory between
+// jobs. Entries are evicted least recently used first once the estimated
+// footprint exceeds the cap.
+class InstanceCache {
+public:
+	struct Entry {
+		shared_ptr<Instance> inst;
+		// deep copy of inst for the committer thread, which must not share lazy
+		// kernel objects with the searches on inst (Solution::deep_copy)
+		shared_ptr<const Instance> frozen;
+		Solution sol;
+		size_t saved_size; // size of the cover on disk
+		size_t bytes;
+	};
+
+	explicit InstanceCache(size_t max_bytes) : m_max_bytes(max_bytes) {}
+
+	Entry& get(const string& name) {
+		auto it = m_entries.find(name);
+		if (it != m_entries.end()) {
+			m_lru.splice(m_lru.begin(), m_lru, it->second.second);
+			return it->second.first;
+		}
+		Entry entry = load(name);
+		m_bytes += entry.bytes;
+		m_lru.push_front(name);
+		auto inserted =
+				m_entries.emplace(name, make_pair(std::move(entry), m_lru.begin()));
+		auto& slot = inserted.first->second.first;
+		evict_to_fit(name);
+		return slot;
+	}
+
+	void evict(const string& name) {
+		auto it = m_entries.find(name);
+		if (it == m_entries.end())
+			return;
+		m_bytes -= it->second.first.bytes;
+		m_lru.erase(it->second.second);
+		m_entries.erase(it);
+	}
+
+	// re-estimate the footprint of an entry after its cover changed
+	void resize(Entry& entry) {
+		m_bytes -= entry.bytes;
+		entry.bytes = estimate_bytes(*entry.inst, entry.sol);
+		m_bytes += entry.bytes;
+	}
+
+	[[nodiscard]] size_t size() const { return m_entries.size(); }
+	[[nodiscard]] size_t bytes() const { return m_bytes; }
+
+private:
+	// rough per-vertex cost of an Epeck point with its lazy representation
+	static constexpr size_t BYTES_PER_VERTEX = 160;
+
+	static size_t estimate_bytes(const Instance& inst, const Solution& sol) {
+		// the instance is held twice, as inst and as frozen
+		size_t vertices = 2 * inst.num_vertices();
+		for (const auto& poly : sol.polygons())
+			vertices += poly.size();
+		return vertices * BYTES_PER_VERTEX;
+	}
+
+	static Entry load(const string& name) {
+		Instance inst = Instance::read_file(name);
+		Solution sol;
+		size_t saved_size = size_t(-1);
+		if (solution_exists(name)) {
+			sol = Solution::read_file(name);
+			SolutionVerifier sv(&inst, &sol);
+			if (sv.verify())
+				saved_size = sol.size();
+			else
+				sol = basicTriangulation(inst);
+		} else {
+			sol = basicTriangulation(inst);
+		}
+		inst.complement();
+		auto frozen = make_shared<const Instance>(inst.deep_copy());
+		size_t bytes = estimate_bytes(inst, sol);
+		return Entry{make_shared<Instance>(std::move(inst)), std::move(frozen),
+								 std::move(sol), saved_size, bytes};
+	}
+
+	void evict_to_fit(const string& keep) {
+		while (m_bytes > m_max_bytes && m_lru.size() > 1) {
+			string victim = m_lru.back();
+			if (victim == keep)
+				break;
+			cerr << "daemon: evicting " << victim << endl;
+			evict(victim);
+		}
+	}
+
+	size_t m_max_bytes;
+	size_t m_bytes = 0;
+	list<string> m_lru;
+	unordered_map<string, pair<Entry, list<string>::iterator>> m_entries;
+};
+
+void run_daemon(istream& in, ostream& out, size_t max_cache_bytes) {
+	using clock = std::chrono::steady_clock;
+	InstanceCache cache(max_cache_bytes);
+	SolutionCommitter committer;
+	// catch up with what the committer has written in the background
+	auto refresh = [&](InstanceCache::Entry& entry, const string& name) {
+		if (auto written = committer.written_size(name))
+			entry.saved_size = min(entry.saved_size, *written);
+	};
+	auto save = [&](InstanceCache::Entry& entry, const string& name) {
+		refresh(entry, name);
+		if (entry.sol.size() >= entry.saved_size)
+			return;
+		// the next job goes on searching on entry.sol, so hand over a deep copy
+		committer.submit(entry.frozen, name, entry.sol.deep_copy());
+	};
+	string line;
+	while (getline(in, line)) {
+		istringstream tokens(line);
+		string command, name;
+		tokens >> command;
+		if (command.empty())
+			continue;
+		if (command == "quit")
+			break;
+		if (command == "stats") {
+			auto commits = committer.stats();
+			out << "ok stats instances=" << cache.size()
+					<< " bytes=" << cache.bytes() << " committed=" << commits.written
+					<< " rejected=" << commits.rejected << endl;
+			continue;
+		}
+		tokens >> name;
+		name = remove_ext(name);
+		try {
+			if (command == "evict") {
+				cache.evict(name);
+				out << "ok evict " << name << endl;
+			} else if (command == "save") {
+				auto& entry = cache.get(name);
+				save(entry, name);
+				committer.flush();
+				refresh(entry, name);
+				out << "ok save " << name << " " << entry.saved_size << endl;
+			} else if (command == "improve") {
+				double seconds = 0;
+				tokens >> seconds;
+				JobConfig config = JobConfig::parse(tokens);
+				auto& entry = cache.get(name);
+				size_t before = entry.sol.size();
+				auto start = clock::now();
+				auto elapsed = [&]() {
+					return std::chrono::duration<double>(clock::now() - start).count();
+				};
+				if (config.portfolio > 0) {
+					PortfolioWorker base;
+					base.shrink_rounds = config.shrink_rounds;
+					base.replacement_choices = config.replacement_choices;
+					base.annealing = config.annealing;
+					base.anneal_config.history_length = config.history_length;
+					run_portfolio(*entry.inst, entry.sol,
+												make_portfolio(config.portfolio, base), 0, seconds);
+				} else if (config.annealing) {
+					AnnealConfig anneal_config;
+					anneal_config.time_limit = seconds;
+					anneal_config.history_length = config.history_length;
+					if (config.replacement_choices > 0)
+						anneal_config.replacement_choices = config.replacement_choices;
+					anneal(*entry.inst, entry.sol, anneal_config);
+				} else {
+					auto deadline =
+							start + chrono::duration_cast<clock::duration>(
+													chrono::duration<double>(seconds));
+					// nothing left to gain once the cover meets the lower bound
+					do {
+						try_remove_all(*entry.inst, entry.sol, true, 0,
+													 config.replacement_choices, config.shrink_rounds,
+													 deadline);
+					} while (elapsed() < seconds &&
+									 entry.sol.size() > cover_lower_bound(*entry.inst));
+				}
+				cache.resize(entry);
+				save(entry, name);
+				out << "ok improve " << name << " " << before << " "
+						<< entry.sol.size() << " " << elapsed() << endl;
+			} else {
+				out << "error unknown command " << command << endl;
+			}
+		} catch (const std::exception& e) {
+			out << "error " << command << " " << name << ": " << e.what() << endl;
+		}
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+
+// Long-running worker: reads one job per line from in and answers on out.
+//   improve <name> <seconds> [anneal] [lahc=N] [shrink=N] [choices=N]
+//           [portfolio=K]
+//   save <name>     write the cached cover if it beats the one on disk
+//   evict <name>    drop an instance from the cache
+//   stats           report cache occupancy
+//   quit
+// Instances, their precomputed complements and current covers stay cached,
+// so repeated jobs skip parsing, triangulation and verification of the
+// starting point. Improvements are handed to a background committer once a job
+// finishes, so the next job starts while they are verified and written.
+void run_daemon(std::istream& in, std::ostream& out,
+								std::size_t max_cache_bytes);
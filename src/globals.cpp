@@ -0,0 +1,7 @@
+#include "globals.hpp"
+
+bool VERBOSE = false;
+bool VISIBILITY_PRUNING = false;
+bool MULTI_ABSORB = false;
+bool SIMPLIFY_RATIONALS = false;
+std::string TRIANGULATION_CACHE;
@@ -1,3 +1,19 @@
 #pragma once
 
-bool VERBOSE = false;
+#include <string>
+
+extern bool VERBOSE;
+
+// prune replacement candidates in try_removal by visibility (--visibility)
+extern bool VISIBILITY_PRUNING;
+
+// spread removed polygons over several neighbours (--multi-absorb)
+extern bool MULTI_ABSORB;
+
+// move complex rational vertices to simpler ones on commit
+// (--simplify-rationals)
+extern bool SIMPLIFY_RATIONALS;
+
+// directory of preprocessed instances for basicTriangulation, empty for none
+// (--tri-cache)
+extern std::string TRIANGULATION_CACHE;
@@ -0,0 +1,705 @@
+#include "localsearch.hpp"
+#include "cgshop2023_core/hilbert_order.hpp"
+#include "cgshop2023_core/lower_bound.hpp"
+#include "cgshop2023_core/profiling.hpp"
+#include "cgshop2023_core/simd_orientation.hpp"
+#include "cgshop2023_core/verify.hpp"
+#include "visibility.hpp"
+#include <CGAL/Boolean_set_operations_2.h>
+#include <CGAL/Polygon_set_2.h>
+#include <CGAL/ch_graham_andrew.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <optional>
+
+// Append to out the points of desired that are not in the convex polygon poly
+// (points in it, boundary included, cannot change its hull). Each point is
+// located in the fan of triangles around vertex 0 by binary search, so this
+// costs O(log n) orientation tests per point; the first two of them are
+// filtered for all points at once with orientation_batch. Returns the number
+// of points dropped.
+static size_t drop_covered(const SimplePolygon& poly,
+													 const vector<Point>& desired, vector<Point>& out) {
+	thread_local vector<double> vx, vy;
+	size_t n = poly.size();
+	vx.resize(n);
+	vy.resize(n);
+	bool doubles = true;
+	for (size_t k = 0; doubles && k < n; ++k)
+		doubles = to_exact_double(poly.vertex(k), vx[k], vy[k]);
+	// orientation of (v[i], v[j], p): the double filter when it is certain,
+	// the exact kernel otherwise
+	auto orient = [&](size_t i, size_t j, const Point& p, double px, double py,
+										bool exact_p) -> int {
+		if (doubles && exact_p) {
+			int o = orientation_filtered(vx[i], vy[i], vx[j], vy[j], px, py);
+			if (o != 0)
+				return o;
+		}
+		return CGAL::orientation(poly.vertex(i), poly.vertex(j), p);
+	};
+	int sign = 0;
+	for (size_t k = 1; sign == 0 && k + 1 < n; ++k)
+		sign = orient(0, k, poly.vertex(k + 1), vx[k + 1], vy[k + 1], doubles);
+	if (sign == 0) {
+		out.insert(out.end(), desired.begin(), desired.end());
+		return 0;
+	}
+
+	// the two tests against the edges of the fan at v[0] that every point
+	// needs, filtered for all points at once; points without exact double
+	// coordinates get NaN, which the filter leaves undecided
+	thread_local vector<double> px, py;
+	thread_local vector<int8_t> first_turn, last_turn;
+	size_t m = desired.size();
+	px.resize(m);
+	py.resize(m);
+	first_turn.assign(m, 0);
+	last_turn.assign(m, 0);
+	for (size_t k = 0; k < m; ++k)
+		if (!to_exact_double(desired[k], px[k], py[k]))
+			px[k] = py[k] = std::numeric_limits<double>::quiet_NaN();
+	if (doubles) {
+		orientation_batch(vx[0], vy[0], vx[1], vy[1], px.data(), py.data(), m,
+											first_turn.data());
+		orientation_batch(vx[0], vy[0], vx[n - 1], vy[n - 1], px.data(),
+											py.data(), m, last_turn.data());
+	}
+
+	size_t dropped = 0;
+	for (size_t k = 0; k < m; ++k) {
+		const Point& p = desired[k];
+		bool exact_p = !std::isnan(px[k]);
+		auto side = [&](size_t i, size_t j) {
+			return sign * orient(i, j, p, px[k], py[k], exact_p);
+		};
+		int first = first_turn[k] != 0 ? sign * first_turn[k] : side(0, 1);
+		int last = last_turn[k] != 0 ? sign * last_turn[k] : side(0, n - 1);
+		bool covered = first >= 0 && last <= 0;
+		if (covered && (first == 0 || last == 0)) {
+			// on a line through v[0] and a neighbour, which may carry further
+			// collinear vertices; rare enough for the linear exact test
+			covered = poly.bounded_side(p) != CGAL::ON_UNBOUNDED_SIDE;
+		} else if (covered) {
+			// last k in [1, n - 2] with p not right of v[0] -> v[k]
+			size_t lo = 1, hi = n - 2;
+			while (lo < hi) {
+				size_t mid = (lo + hi + 1) / 2;
+				if (side(0, mid) >= 0)
+					lo = mid;
+				else
+					hi = mid - 1;
+			}
+			covered = side(lo, lo + 1) >= 0;
+		}
+		if (covered)
+			++dropped;
+		else
+			out.push_back(p);
+	}
+	profiling::count("greedy_expand.covered_points", dropped);
+	return dropped;
+}
+
+// Cheap check that certainly rejects expanding poly towards desired, run
+// before the hull is built; false means it could not decide. It counts its
+// rejections like the exact containment test after it, so the metrics show
+// where candidates fail. (The desired points are cover vertices, so they are
+// always inside the instance's bounding box; there is nothing to gain there.)
+static bool prefilter_rejects(const Instance& inst, const SimplePolygon& poly,
+															const vector<Point>& desired) {
+	profiling::ScopedTimer timer("greedy_expand.prefilter");
+	const IntBoundary& boundary = inst.boundary();
+	if (!boundary.valid())
+		return false;
+
+	// a boundary edge crossing the segment from an interior point of poly
+	// (a triangle centroid, scaled by 3) to a desired point; the segment lies
+	// in the new hull, so the hull would leave the instance
+	IntPoint a, b, c;
+	if (poly.size() < 3 || !to_int_point(poly.vertex(0), a))
+		return false;
+	int sign = 0;
+	for (size_t k = 1; sign == 0 && k + 1 < poly.size(); ++k) {
+		if (!to_int_point(poly.vertex(k), b) ||
+				!to_int_point(poly.vertex(k + 1), c))
+			return false;
+		sign = int_orientation(a, b, c);
+	}
+	if (sign == 0)
+		return false;
+	IntPoint centroid{a.x + b.x + c.x, a.y + b.y + c.y};
+	for (const Point& p : desired) {
+		IntPoint q;
+		if (!to_int_point(p, q))
+			continue;
+		if (boundary.segment_crosses(centroid, IntPoint{3 * q.x, 3 * q.y}, 3)) {
+			profiling::count("greedy_expand.reject.segment");
+			return true;
+		}
+	}
+	return false;
+}
+
+// Is the convex polygon hull (with vertices chull) inside the instance?
+// integer method: if every hull vertex is an integer point, the hull only has
+// to be checked against the integer copy of the boundary (sets integral);
+// otherwise CGAL oriented side and complement method
+static bool convex_inside(Instance& inst, const vector<Point>& chull,
+													const SimplePolygon& hull, bool& integral) {
+	const IntBoundary& boundary = inst.boundary();
+	thread_local vector<IntPoint> int_hull;
+	int_hull.clear();
+	integral = boundary.valid() && chull.size() >= 3;
+	for (size_t k = 0; integral && k < chull.size(); ++k) {
+		IntPoint q;
+		integral = to_int_point(chull[k], q);
+		int_hull.push_back(q);
+	}
+	if (integral)
+		return boundary.contains_convex(int_hull);
+	for (auto& outside_piece : inst.complement()) {
+		// does the exterior of one intersect the interior of the other
+		if (CGAL::oriented_side(outside_piece, hull) == CGAL::ON_POSITIVE_SIDE)
+			return false;
+	}
+	return true;
+}
+
+SimplePolygon greedy_expand(Instance& inst, SimplePolygon poly,
+														const vector<Point>& desired_coverage,
+														bool& allCovered) {
+	profiling::ScopedTimer timer("greedy_expand");
+	profiling::count("greedy_expand.calls");
+	allCovered = true;
+	// scratch buffers, reused across calls so their capacity is allocated once
+	thread_local vector<Point> missing, points, chull;
+	missing.clear();
+	drop_covered(poly, desired_coverage, missing);
+	if (missing.empty()) {
+		// poly already covers everything
+		profiling::count("greedy_expand.all_covered");
+		profiling::count("greedy_expand.accepted");
+		return poly;
+	}
+	if (prefilter_rejects(inst, poly, missing)) {
+		allCovered = false;
+		return poly;
+	}
+	// decide wether to add p to poly
+	// look at what the new polygon would be by computing convex hull (very lazy
+	// method) this could be improved to O(log n) with binary search (and the
+	// new edges could be singled out)
+	points.assign(poly.vertices_begin(), poly.vertices_end());
+	points.insert(points.end(), missing.begin(), missing.end());
+	// get the convex hull
+	chull.clear();
+	{
+		profiling::ScopedTimer hull_timer("greedy_expand.hull");
+		CGAL::ch_graham_andrew(points.begin(), points.end(),
+													 std::back_inserter(chull));
+	}
+	SimplePolygon newPoly(chull.begin(), chull.end());
+
+	// is it inside the polygon
+	bool inside = false;
+	// optimal method: Triangulate the base polygon, create point location data
+	// structure and compute tree-cotree decomposition. Check if new loop is
+	// trivial, and if any edge intersects the outside (can check only the two
+	// new edges for this, and precompute the z2-homology values along paths for
+	// all) complexity becomes the complexity of checking whether a line segment
+	// intersects a polygon (does a data structure exist for this? still fairly
+	// efficient in practice with point location) that's a lot of work to
+	// implement, so instead we use cgal's methods (probably much, much slower)
+
+	bool integral = false;
+	{
+		profiling::ScopedTimer containment_timer("greedy_expand.containment");
+		inside = convex_inside(inst, chull, newPoly, integral);
+	}
+	if (integral)
+		profiling::count("greedy_expand.int_path");
+
+	// CGAL area computation method
+	/*
+	std::vector<Polygon> coverage = {};
+	std::vector<Polygon> polys = {inst.polygon(), Polygon(newPoly)};
+	CGAL::join(polys.begin(), polys.end(), std::back_inserter(coverage));
+	inside = inside || (coverage.size() == 1 && area(coverage[0]) <= outerArea);
+	*/
+
+	if (inside) {
+		// it is inside, so add it
+		profiling::count("greedy_expand.accepted");
+		poly = newPoly;
+	} else {
+		profiling::count("greedy_expand.reject.containment");
+		allCovered = false;
+	}
+
+	return poly;
+}
+
+thread_local std::mt19937 g(std::random_device{}());
+
+vector<SimplePolygon> get_missing(const Instance& inst,
+																	const vector<SimplePolygon>& partial_cover) {
+	vector<Polygon> to_join;
+	for (auto& poly : partial_cover) {
+		to_join.push_back(Polygon(poly));
+	}
+	for (const auto& poly : inst.complement())
+		to_join.push_back(poly);
+	std::vector<Polygon> coverage = {};
+	CGAL::join(to_join.begin(), to_join.end(), std::back_inserter(coverage));
+
+	assert(coverage.size() == 1);
+
+	vector<SimplePolygon> output;
+	for (auto& poly : coverage[0].holes())
+		output.push_back(poly);
+
+	return output;
+}
+
+vector<SimplePolygon>
+get_missing_removal(const Instance& inst,
+										const vector<SimplePolygon>& full_cover, size_t polygon_i) {
+	vector<SimplePolygon> partial_cover;
+	for (size_t i = 0; i < full_cover.size(); ++i) {
+		if (i == polygon_i)
+			continue;
+		partial_cover.push_back(full_cover[i]);
+	}
+	return get_missing(inst, partial_cover);
+}
+
+bool fits_solution_format(const Point& p) {
+	auto fits = [](const Kernel::FT& v) {
+		using limits = std::numeric_limits<std::int64_t>;
+		auto num = boost::multiprecision::numerator(v.exact());
+		auto den = boost::multiprecision::denominator(v.exact());
+		return num >= limits::min() && num <= limits::max() && den <= limits::max();
+	};
+	return fits(p.x()) && fits(p.y());
+}
+
+// bits of numerator and denominator of the more complex coordinate of p
+static size_t coordinate_bits(const Point& p) {
+	auto bits = [](const Kernel::FT& v) {
+		auto num = boost::multiprecision::numerator(v.exact());
+		auto den = boost::multiprecision::denominator(v.exact());
+		if (num < 0)
+			num = -num;
+		size_t n = num == 0 ? 0 : boost::multiprecision::msb(num) + 1;
+		return n + boost::multiprecision::msb(den) + 1;
+	};
+	IntPoint q;
+	if (to_int_point(p, q))
+		return 0;
+	return max(bits(p.x()), bits(p.y()));
+}
+
+// Move vertex i of the convex polygon verts outwards to a corner of the grid
+// of spacing 1/d around it, for increasingly fine d, such that the new hull
+// still contains every old vertex and stays inside the instance. Only corners
+// within SIMPLE_COORDINATE_BITS are tried, so every success replaces a complex
+// vertex by a simple one and normalize_polygon cannot cycle. Returns the new
+// hull if some corner works.
+static optional<vector<Point>> round_vertex(Instance& inst,
+																						const vector<Point>& verts,
+																						size_t i) {
+	SimplePolygon old(verts.begin(), verts.end());
+	double x = CGAL::to_double(verts[i].x());
+	double y = CGAL::to_double(verts[i].y());
+	vector<Point> points, hull;
+	for (double d : {1.0, 16.0, 256.0, 65536.0}) {
+		double x0 = std::floor(x * d), y0 = std::floor(y * d);
+		for (double cx : {x0, x0 + 1})
+			for (double cy : {y0, y0 + 1}) {
+				Point c(Kernel::FT(cx) / Kernel::FT(d), Kernel::FT(cy) / Kernel::FT(d));
+				// far from the origin the finer grids are no simpler than verts[i]
+				if (coordinate_bits(c) > SIMPLE_COORDINATE_BITS)
+					continue;
+				// a corner in the old polygon cannot keep verts[i] covered
+				if (old.bounded_side(c) != CGAL::ON_UNBOUNDED_SIDE)
+					continue;
+				points = verts;
+				points[i] = c;
+				hull.clear();
+				CGAL::ch_graham_andrew(points.begin(), points.end(),
+															 std::back_inserter(hull));
+				SimplePolygon next(hull.begin(), hull.end());
+				bool covers = all_of(verts.begin(), verts.end(), [&](const Point& p) {
+					return next.bounded_side(p) != CGAL::ON_UNBOUNDED_SIDE;
+				});
+				bool integral = false;
+				if (covers && convex_inside(inst, hull, next, integral))
+					return hull;
+			}
+	}
+	return nullopt;
+}
+
+void normalize_polygon(Instance& inst, SimplePolygon& poly) {
+	profiling::ScopedTimer timer("normalize");
+	profiling::count("normalize.calls");
+	// drop repeated vertices and the middle one of collinear triples; for a
+	// convex polygon that is the vertex between the other two
+	vector<Point> verts;
+	for (const Point& p : poly) {
+		if (!verts.empty() && verts.back() == p)
+			continue;
+		while (verts.size() >= 2 &&
+					 CGAL::collinear(verts[verts.size() - 2], verts.back(), p))
+			verts.pop_back();
+		verts.push_back(p);
+	}
+	while (verts.size() >= 3 &&
+				 (verts.back() == verts.front() ||
+					CGAL::collinear(verts[verts.size() - 2], verts.back(), verts[0])))
+		verts.pop_back();
+	while (verts.size() >= 3 &&
+				 CGAL::collinear(verts.back(), verts[0], verts[1]))
+		verts.erase(verts.begin());
+	if (verts.size() < 3)
+		return; // degenerate, leave it alone
+
+	if (SIMPLIFY_RATIONALS) {
+		// vertices that could not be moved are not tried again
+		vector<Point> stuck;
+		for (bool changed = true; changed;) {
+			changed = false;
+			for (size_t i = 0; i < verts.size() && !changed; ++i) {
+				if (coordinate_bits(verts[i]) <= SIMPLE_COORDINATE_BITS ||
+						find(stuck.begin(), stuck.end(), verts[i]) != stuck.end())
+					continue;
+				profiling::count("normalize.round_attempts");
+				if (auto hull = round_vertex(inst, verts, i)) {
+					profiling::count("normalize.rounded");
+					verts = std::move(*hull);
+					changed = true;
+				} else {
+					stuck.push_back(verts[i]);
+				}
+			}
+		}
+	}
+
+	profiling::count("normalize.dropped",
+									 poly.size() > verts.size() ? poly.size() - verts.size() : 0);
+	profiling::count("normalize.vertices", verts.size());
+	poly = SimplePolygon(verts.begin(), verts.end());
+}
+
+SimplePolygon minimize_to_necessary(const vector<SimplePolygon>& full_cover,
+																		const CoverageIndex& index,
+																		size_t polygon_i, bool& redundant) {
+	profiling::ScopedTimer timer("shrink");
+	profiling::count("shrink.calls");
+	const SimplePolygon& poly = full_cover[polygon_i];
+	redundant = false;
+	CGAL::Polygon_set_2<Kernel> only_i(poly);
+	for (size_t j : index.overlapping(polygon_i)) {
+		only_i.difference(full_cover[j]);
+		if (only_i.is_empty()) {
+			profiling::count("shrink.redundant");
+			redundant = true;
+			return poly;
+		}
+	}
+	vector<Polygon> missing;
+	only_i.polygons_with_holes(std::back_inserter(missing));
+	vector<Point> pointset;
+	for (const auto& piece : missing) {
+		// holes of a piece are covered by others and lie inside its outer hull
+		for (const auto& pt : piece.outer_boundary())
+			pointset.push_back(pt);
+	}
+	// get the convex hull
+	vector<Point> chull;
+	CGAL::ch_graham_andrew(pointset.begin(), pointset.end(),
+												 std::back_inserter(chull));
+	if (!all_of(chull.begin(), chull.end(), fits_solution_format))
+		return poly;
+	SimplePolygon newPoly(chull.begin(), chull.end());
+	return newPoly;
+}
+
+Kernel::FT compute_area(const vector<SimplePolygon>& missing) {
+	Kernel::FT cur_area(0);
+	for (auto& poly : missing) {
+		cur_area += poly.area();
+	}
+	return cur_area;
+}
+
+double removal_score_base(const Instance& inst,
+													const vector<SimplePolygon>& current_cover,
+													size_t polygon_i) {
+	auto missing_current = get_missing(inst, current_cover);
+	auto missing_next = get_missing_removal(inst, current_cover, polygon_i);
+	auto total_area_current = compute_area(missing_current);
+	auto total_area_next = compute_area(missing_next);
+	auto count_current = missing_current.size();
+	auto count_next = missing_next.size();
+
+	// negative = worse score
+	auto area_delta = CGAL::to_double(total_area_current - total_area_next);
+	auto count_delta = count_next - count_current;
+	return 8 * area_delta + 4 * count_delta;
+}
+
+bool try_removal(Instance& inst, Solution& sol, size_t polygon_i,
+								 bool randomize, size_t replacement_choices,
+								 CoverageIndex* index) {
+	profiling::ScopedTimer timer("try_removal");
+	profiling::count("removal.attempts");
+	vector<Point> desired_coverage(sol.polygons()[polygon_i].begin(),
+																 sol.polygons()[polygon_i].end());
+	// try to remove polygon_i
+	// do it by trying to get polygons in sol to cover it's vertices
+	vector<int> to_try;
+	for (size_t i = 0; i < sol.polygons().size(); ++i)
+		if (i != polygon_i)
+			to_try.push_back(i);
+	if (randomize)
+		shuffle(to_try.begin(), to_try.end(), g);
+	// regions of the points to absorb, looked up once for all candidates
+	vector<VisibilityService::Region> desired_regions;
+	if (VISIBILITY_PRUNING)
+		desired_regions =
+				VisibilityService::for_instance(inst).regions(desired_coverage);
+	bool succeeded = false;
+	// candidates pruned by visibility do not count as replacement choices
+	size_t tried = 0;
+	for (size_t i = 0; i < to_try.size() &&
+										 (replacement_choices == 0 || tried < replacement_choices);
+			 ++i) {
+		if (VERBOSE) {
+			// cerr << "Doing " << i << "th replacement choice for polygon " <<
+			// polygon_i
+			//		 << endl;
+		}
+		size_t cur_i = to_try[i];
+		if (VISIBILITY_PRUNING &&
+				!VisibilityService::sees_all(desired_regions, sol.polygons()[cur_i])) {
+			profiling::count("visibility.pruned");
+			continue;
+		}
+		++tried;
+		bool allCovered = false;
+		SimplePolygon newPoly = greedy_expand(inst, sol.polygons()[cur_i],
+																					desired_coverage, allCovered);
+		if (allCovered) {
+			normalize_polygon(inst, newPoly);
+			if (index)
+				index->update(cur_i, newPoly);
+			sol.polygons_m()[cur_i] = std::move(newPoly);
+			profiling::count("removal.success");
+			succeeded = true;
+			break;
+		}
+	}
+	return succeeded;
+}
+
+bool try_multi_removal(Instance& inst, Solution& sol, size_t polygon_i,
+											 CoverageIndex& index) {
+	profiling::ScopedTimer timer("multi_removal");
+	profiling::count("multi_removal.attempts");
+	const SimplePolygon& removed = sol.polygons()[polygon_i];
+	vector<size_t> neighbours = index.overlapping(polygon_i);
+	if (neighbours.empty())
+		return false;
+	// the part of the removed polygon that no neighbour covers yet
+	CGAL::Polygon_set_2<Kernel> missing(removed);
+	for (size_t j : neighbours)
+		missing.difference(sol.polygons()[j]);
+	vector<Polygon> pieces;
+	missing.polygons_with_holes(std::back_inserter(pieces));
+
+	// grown neighbours, only written back once every piece has found a taker
+	std::map<size_t, SimplePolygon> grown;
+	auto current = [&](size_t j) -> const SimplePolygon& {
+		auto it = grown.find(j);
+		return it == grown.end() ? sol.polygons()[j] : it->second;
+	};
+	// let the nearest neighbour that can reach all of targets absorb them
+	auto absorb = [&](const Polygon& piece) {
+		vector<Point> targets(piece.outer_boundary().begin(),
+													piece.outer_boundary().end());
+		CGAL::Bbox_2 box = piece.outer_boundary().bbox();
+		auto distance = [&](size_t j) {
+			CGAL::Bbox_2 other = current(j).bbox();
+			double dx =
+					max({0.0, box.xmin() - other.xmax(), other.xmin() - box.xmax()});
+			double dy =
+					max({0.0, box.ymin() - other.ymax(), other.ymin() - box.ymax()});
+			return dx * dx + dy * dy;
+		};
+		sort(neighbours.begin(), neighbours.end(),
+				 [&](size_t a, size_t b) { return distance(a) < distance(b); });
+		for (size_t j : neighbours) {
+			bool allCovered = false;
+			SimplePolygon poly =
+					greedy_expand(inst, current(j), targets, allCovered);
+			if (allCovered &&
+					all_of(poly.begin(), poly.end(), fits_solution_format)) {
+				grown[j] = std::move(poly);
+				return true;
+			}
+		}
+		return false;
+	};
+
+	for (const auto& piece : pieces) {
+		if (absorb(piece))
+			continue;
+		// no single neighbour reaches the whole piece: split it along the fan of
+		// triangles of the removed polygon and place the parts separately
+		profiling::count("multi_removal.splits");
+		for (size_t k = 1; k + 1 < removed.size(); ++k) {
+			SimplePolygon tri;
+			tri.push_back(removed.vertex(0));
+			tri.push_back(removed.vertex(k));
+			tri.push_back(removed.vertex(k + 1));
+			if (tri.orientation() == CGAL::COLLINEAR)
+				continue;
+			if (tri.orientation() == CGAL::CLOCKWISE)
+				tri.reverse_orientation();
+			CGAL::Polygon_set_2<Kernel> part(tri);
+			part.intersection(piece);
+			vector<Polygon> parts;
+			part.polygons_with_holes(std::back_inserter(parts));
+			for (const auto& p : parts) {
+				if (!absorb(p)) {
+					profiling::count("multi_removal.failed");
+					return false;
+				}
+			}
+		}
+	}
+
+	for (auto& [j, poly] : grown) {
+		normalize_polygon(inst, poly);
+		index.update(j, poly);
+		sol.polygons_m()[j] = std::move(poly);
+	}
+	profiling::count("multi_removal.success");
+	return true;
+}
+
+void remove_polygon(Solution& sol, size_t polygon_i,
+										CoverageIndex* index) {
+	if (index)
+		index->swap_remove(polygon_i);
+	swap(sol.polygons_m()[polygon_i],
+			 sol.polygons_m()[sol.polygons().size() - 1]);
+	sol.polygons_m().pop_back();
+}
+
+void removal_if_possible(Instance& inst, Solution& sol, size_t polygon_i,
+												 bool randomize, size_t replacement_choices,
+												 CoverageIndex* index) {
+	if (try_removal(inst, sol, polygon_i, randomize, replacement_choices,
+									index) ||
+			(MULTI_ABSORB && index &&
+			 try_multi_removal(inst, sol, polygon_i, *index))) {
+		remove_polygon(sol, polygon_i, index);
+	}
+}
+
+size_t shrink_all(Solution& sol, CoverageIndex& index) {
+	size_t dropped = 0;
+	for (size_t polygon_i = sol.polygons().size(); polygon_i-- > 0;) {
+		bool redundant = false;
+		SimplePolygon newPoly =
+				minimize_to_necessary(sol.polygons(), index, polygon_i, redundant);
+		if (redundant) {
+			remove_polygon(sol, polygon_i, &index);
+			++dropped;
+		} else {
+			sol.polygons_m()[polygon_i] = newPoly;
+			index.update(polygon_i, newPoly);
+		}
+	}
+	return dropped;
+}
+
+void removal_pass(Instance& inst, Solution& sol, bool randomize,
+									size_t removal_attempts, size_t replacement_choices,
+									CoverageIndex* index,
+									Deadline deadline) {
+	vector<int> to_remove;
+	for (int polygon_i = sol.polygons().size() - 1; polygon_i >= 0; --polygon_i)
+		to_remove.push_back(polygon_i);
+	if (randomize)
+		shuffle(to_remove.begin(), to_remove.end(), g);
+	size_t bound = cover_lower_bound(inst);
+	for (size_t i = 0;
+			 i < to_remove.size() && (removal_attempts == 0 || i < removal_attempts);
+			 ++i) {
+		// a cover of the size of the lower bound is optimal
+		if (sol.polygons().size() <= bound)
+			break;
+		if (deadline != NO_DEADLINE &&
+				std::chrono::steady_clock::now() >= deadline)
+			break;
+		// earlier removals may have shrunk the solution below this index
+		if (size_t(to_remove[i]) >= sol.polygons().size())
+			continue;
+		if (VERBOSE) {
+			cerr << "Doing " << i << "th try remove (polygon number " << i << ": "
+					 << to_remove[i] << ")" << endl;
+		}
+		removal_if_possible(inst, sol, to_remove[i], randomize,
+												replacement_choices, index);
+	}
+}
+
+void try_remove_all(Instance& inst, Solution& sol, bool randomize,
+										size_t removal_attempts, size_t replacement_choices,
+										size_t shrink_rounds,
+										Deadline deadline) {
+	cerr << "Running try_remove_all on " << sol.polygons().size()
+			 << " polygons\n";
+	size_t bound = cover_lower_bound(inst);
+	if (sol.polygons().size() <= bound) {
+		cerr << "Cover is optimal (lower bound " << bound
+				 << "), nothing to remove\n";
+		return;
+	}
+	sort_by_hilbert(sol.polygons_m());
+	// multi-polygon absorption needs the coverage index to find neighbours
+	if (shrink_rounds == 0 && !MULTI_ABSORB) {
+		removal_pass(inst, sol, randomize, removal_attempts, replacement_choices,
+								 nullptr, deadline);
+	} else {
+		CoverageIndex index(inst, sol.polygons());
+		removal_pass(inst, sol, randomize, removal_attempts, replacement_choices,
+								 &index, deadline);
+		for (size_t round = 0; round < shrink_rounds; ++round) {
+			// removals moved polygons from the end into the gaps
+			sort_by_hilbert(sol.polygons_m());
+			index = CoverageIndex(inst, sol.polygons());
+			size_t before = sol.polygons().size();
+			size_t dropped = shrink_all(sol, index);
+			removal_pass(inst, sol, randomize, removal_attempts, replacement_choices,
+									 &index, deadline);
+			if (VERBOSE) {
+				cerr << "Shrink round " << round << ": dropped " << dropped
+						 << " redundant polygons, now have " << sol.polygons().size()
+						 << " polygons" << endl;
+			}
+			if (sol.polygons().size() == before ||
+					sol.polygons().size() <= bound ||
+					std::chrono::steady_clock::now() >= deadline)
+				break;
+		}
+	}
+	cerr << "Finished running try_remove_all, now have " << sol.polygons().size()
+			 << " polygons\n";
+}
@@ -0,0 +1,125 @@
+#include "pipeline.hpp"
+#include "globals.hpp"
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+static double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// runs one stage on the calling thread and books its time and metrics on job
+static void run_stage(const function<void(PipelineJob&)>& stage,
+											PipelineJob& job) {
+	if (!stage)
+		return;
+	if (profiling::enabled)
+		profiling::take();
+	auto start = chrono::steady_clock::now();
+	stage(job);
+	job.seconds += seconds_since(start);
+	if (profiling::enabled)
+		job.stats.merge(profiling::take());
+}
+
+void run_pipeline(const vector<string>& files, size_t num_threads,
+									size_t prefetch, const PipelineStages& stages) {
+	using JobPtr = unique_ptr<PipelineJob>;
+	num_threads = max<size_t>(num_threads, 1);
+	size_t num_loaders = clamp<size_t>(prefetch, 1, 2);
+	BoundedQueue<JobPtr> ready(prefetch), finished(prefetch);
+
+	atomic<size_t> next_file{0}, loaders_left{num_loaders},
+			workers_left{num_threads}, written{0};
+	// time spent blocked on the queues, per thread
+	vector<double> loader_wait(num_loaders, 0), worker_wait(num_threads, 0);
+	mutex out_mtx;
+	size_t started = 0;
+
+	vector<thread> loaders;
+	for (size_t l = 0; l < num_loaders; ++l) {
+		loaders.emplace_back([&, l]() {
+			for (size_t i; (i = next_file++) < files.size();) {
+				if (stages.claim && !stages.claim(files[i]))
+					continue;
+				auto job = make_unique<PipelineJob>();
+				job->name = files[i];
+				try {
+					run_stage(stages.load, *job);
+				} catch (const exception& e) {
+					{
+						lock_guard<mutex> lock(out_mtx);
+						cerr << "Skipping " << job->name << ": " << e.what() << endl;
+					}
+					if (stages.release)
+						stages.release(job->name, false);
+					continue;
+				}
+				auto start = chrono::steady_clock::now();
+				ready.push(std::move(job));
+				loader_wait[l] += seconds_since(start);
+			}
+			if (--loaders_left == 0)
+				ready.close();
+		});
+	}
+
+	vector<thread> workers;
+	for (size_t t = 0; t < num_threads; ++t) {
+		workers.emplace_back([&, t]() {
+			while (true) {
+				auto start = chrono::steady_clock::now();
+				auto job = ready.pop();
+				worker_wait[t] += seconds_since(start);
+				if (!job)
+					break;
+				{
+					lock_guard<mutex> lock(out_mtx);
+					++started;
+					cout << "thread " << t << " processing file " << started << "/"
+							 << files.size() << ": " << (*job)->name << endl;
+					if (VERBOSE)
+						cerr << "pipeline: ready queue " << ready.depth()
+								 << ", write queue " << finished.depth() << endl;
+				}
+				run_stage(stages.compute, **job);
+				finished.push(std::move(*job));
+			}
+			if (--workers_left == 0)
+				finished.close();
+		});
+	}
+
+	thread writer([&]() {
+		while (auto job = finished.pop()) {
+			run_stage(stages.write, **job);
+			if (stages.finished)
+				stages.finished(**job);
+			if (stages.release)
+				stages.release((*job)->name, true);
+			++written;
+		}
+	});
+
+	for (auto& loader : loaders)
+		loader.join();
+	for (auto& worker : workers)
+		worker.join();
+	writer.join();
+
+	double loaders_blocked = 0, workers_starved = 0;
+	for (double w : loader_wait)
+		loaders_blocked += w;
+	for (double w : worker_wait)
+		workers_starved += w;
+	cerr << "Pipeline: wrote " << written << "/" << files.size()
+			 << " jobs; max queue depth ready " << ready.max_depth() << "/"
+			 << ready.capacity() << ", write " << finished.max_depth() << "/"
+			 << finished.capacity() << "; workers waited " << workers_starved
+			 << "s for loads, loaders waited " << loaders_blocked
+			 << "s for free slots" << endl;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "cgshop2023_core/cpp_instance.hpp"
+#include "cgshop2023_core/profiling.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace cgshop2023;
+
+// Fixed-capacity blocking FIFO between two pipeline stages. Producers block
+// while it is full and consumers while it is empty; after close() consumers
+// drain what is left and then get nullopt.
+template <typename T> class BoundedQueue {
+public:
+	explicit BoundedQueue(std::size_t capacity)
+			: m_capacity(std::max<std::size_t>(capacity, 1)) {}
+
+	void push(T item) {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_not_full.wait(lock, [&]() { return m_items.size() < m_capacity; });
+		m_items.push_back(std::move(item));
+		m_max_depth = std::max(m_max_depth, m_items.size());
+		m_not_empty.notify_one();
+	}
+
+	std::optional<T> pop() {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_not_empty.wait(lock, [&]() { return !m_items.empty() || m_closed; });
+		if (m_items.empty())
+			return std::nullopt;
+		T item = std::move(m_items.front());
+		m_items.pop_front();
+		m_not_full.notify_one();
+		return item;
+	}
+
+	void close() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_closed = true;
+		m_not_empty.notify_all();
+	}
+
+	[[nodiscard]] std::size_t depth() const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_items.size();
+	}
+	[[nodiscard]] std::size_t max_depth() const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_max_depth;
+	}
+	[[nodiscard]] std::size_t capacity() const { return m_capacity; }
+
+private:
+	mutable std::mutex m_mutex;
+	std::condition_variable m_not_full, m_not_empty;
+	std::deque<T> m_items;
+	std::size_t m_capacity;
+	std::size_t m_max_depth = 0;
+	bool m_closed = false;
+};
+
+// One instance on its way through the pipeline.
+struct PipelineJob {
+	std::string name;
+	std::shared_ptr<Instance> inst;
+	Solution sol;
+	// metrics of all stages (if profiling is enabled) and the time spent in
+	// them, not counting waits in the queues
+	profiling::Registry stats;
+	double seconds = 0;
+};
+
+struct PipelineStages {
+	std::function<void(PipelineJob&)> load;
+	std::function<void(PipelineJob&)> compute;
+	std::function<void(PipelineJob&)> write;
+	// called by the writer after write, e.g. to report metrics
+	std::function<void(const PipelineJob&)> finished;
+	// if set, a file is only loaded if claim returns true for it, and release
+	// is called once it is finished (done) or given up
+	std::function<bool(const std::string&)> claim;
+	std::function<void(const std::string&, bool done)> release;
+};
+
+// Run every file through load, compute and write. A small loader pool (at most
+// two threads) runs up to prefetch jobs ahead of the num_threads compute
+// workers, and one writer thread drains finished jobs, so compute workers only
+// wait for I/O when the loaders cannot keep up. Jobs whose load throws are
+// skipped. The queue depths and waiting times are reported on stderr.
+void run_pipeline(const std::vector<std::string>& files,
+									std::size_t num_threads, std::size_t prefetch,
+									const PipelineStages& stages);
@@ -0,0 +1,134 @@
+#include "portfolio.hpp"
+#include "cgshop2023_core/lower_bound.hpp"
+#include "cgshop2023_core/profiling.hpp"
+#include "globals.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+vector<PortfolioWorker> make_portfolio(size_t k, const PortfolioWorker& base) {
+	vector<PortfolioWorker> workers;
+	std::random_device seeds;
+	for (size_t w = 0; w < k; ++w) {
+		PortfolioWorker worker = base;
+		worker.seed = (uint64_t(seeds()) << 32) ^ seeds();
+		if (w > 0) {
+			worker.randomize = true;
+			size_t choices = base.replacement_choices ? base.replacement_choices : 32;
+			worker.replacement_choices = w % 2 ? choices * (w + 1) : choices / w + 1;
+			worker.shrink_rounds = w % 3 == 0 ? base.shrink_rounds : w % 3;
+			if (base.annealing && w % 2 == 0)
+				worker.anneal_config.history_length = 1000 * w;
+		}
+		workers.push_back(worker);
+	}
+	return workers;
+}
+
+// Best cover found by any worker. Workers poll the size (a plain atomic) after
+// every round and only take the mutex to offer or adopt a cover. The stored
+// cover is a deep copy that only ever gets touched under the mutex, and
+// offering and adopting both copy again, so no lazy kernel object is shared
+// between two threads.
+class SharedBest {
+public:
+	explicit SharedBest(const Solution& initial)
+			: m_size(initial.size()), m_best(initial.deep_copy()) {}
+
+	[[nodiscard]] size_t size() const { return m_size.load(); }
+
+	[[nodiscard]] Solution copy() const {
+		lock_guard<mutex> lock(m_mutex);
+		return m_best.deep_copy();
+	}
+
+	// publish a copy of sol if it is smaller than the current best
+	bool offer(const Solution& sol) {
+		if (sol.size() >= size())
+			return false;
+		Solution mine = sol.deep_copy();
+		lock_guard<mutex> lock(m_mutex);
+		if (mine.size() >= m_best.size())
+			return false;
+		m_best = std::move(mine);
+		m_size.store(m_best.size());
+		return true;
+	}
+
+private:
+	std::atomic<size_t> m_size;
+	mutable mutex m_mutex;
+	Solution m_best;
+};
+
+void run_portfolio(Instance& inst, Solution& sol,
+									 const vector<PortfolioWorker>& workers, size_t rounds,
+									 double time_limit) {
+	using clock = std::chrono::steady_clock;
+	auto start = clock::now();
+	auto elapsed = [&]() {
+		return std::chrono::duration<double>(clock::now() - start).count();
+	};
+	if (rounds == 0 && time_limit <= 0)
+		rounds = 1;
+
+	cerr << "Running portfolio of " << workers.size() << " workers on "
+			 << sol.size() << " polygons\n";
+	// memoized per instance id, which the copies share
+	cover_lower_bound(inst);
+	vector<Instance> instances;
+	for (size_t w = 0; w < workers.size(); ++w)
+		instances.push_back(inst.deep_copy());
+	SharedBest best(sol);
+	Deadline deadline = NO_DEADLINE;
+	if (time_limit > 0)
+		deadline = start + chrono::duration_cast<clock::duration>(
+													 chrono::duration<double>(time_limit));
+
+	bool profile = profiling::enabled;
+	vector<profiling::Registry> worker_stats(workers.size());
+	vector<thread> pool;
+	for (size_t w = 0; w < workers.size(); ++w) {
+		pool.emplace_back([&, w]() {
+			const PortfolioWorker& worker = workers[w];
+			Instance& own = instances[w];
+			g.seed(worker.seed);
+			Solution mine = best.copy();
+			for (size_t round = 0; (rounds == 0 || round < rounds) &&
+														 (time_limit <= 0 || elapsed() < time_limit);
+					 ++round) {
+				if (best.size() < mine.size())
+					mine = best.copy();
+				size_t before = mine.size();
+				try_remove_all(own, mine, worker.randomize, worker.removal_attempts,
+											 worker.replacement_choices, worker.shrink_rounds,
+											 deadline);
+				if (worker.annealing) {
+					AnnealConfig config = worker.anneal_config;
+					if (time_limit > 0)
+						config.time_limit =
+								min(config.time_limit > 0 ? config.time_limit : time_limit,
+										max(time_limit - elapsed(), 0.0));
+					anneal(own, mine, config);
+				}
+				if (best.offer(mine)) {
+					cerr << "portfolio worker " << w << " improved to " << mine.size()
+							 << " polygons after " << elapsed() << "s" << endl;
+				}
+				// a deterministic worker that made no progress is done
+				if (!worker.randomize && !worker.annealing && mine.size() == before)
+					break;
+			}
+			if (profile)
+				worker_stats[w] = profiling::take();
+		});
+	}
+	for (auto& t : pool)
+		t.join();
+	for (const auto& stats : worker_stats)
+		profiling::local().merge(stats);
+
+	sol = best.copy();
+	cerr << "Finished portfolio, now have " << sol.size() << " polygons\n";
+}
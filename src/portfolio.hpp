@@ -0,0 +1,37 @@
+#pragma once
+
+#include "annealing.hpp"
+#include "cgshop2023_core/cpp_instance.hpp"
+#include "localsearch.hpp"
+#include <cstdint>
+#include <vector>
+
+using namespace cgshop2023;
+using namespace std;
+
+// One search configuration raced by run_portfolio.
+struct PortfolioWorker {
+	uint64_t seed = 0;
+	bool randomize = true;
+	size_t removal_attempts = 0;
+	size_t replacement_choices = 0;
+	size_t shrink_rounds = 0;
+	bool annealing = false;
+	AnnealConfig anneal_config;
+};
+
+// Derive k differently seeded and configured workers from the command-line
+// configuration. Worker 0 runs that configuration unchanged, the others
+// randomize and vary how many replacements and shrink rounds they try.
+vector<PortfolioWorker> make_portfolio(size_t k, const PortfolioWorker& base);
+
+// Race the workers on the instance for up to time_limit seconds or rounds
+// rounds per worker. Every worker searches on its own deep copies of the
+// instance and the cover (Solution::deep_copy), so no lazy kernel object is
+// shared between threads. Every round a worker runs try_remove_all (and
+// anneal, if configured); if another worker has found a smaller cover
+// meanwhile, it restarts from a copy of that one. sol is replaced by the best
+// cover found.
+void run_portfolio(Instance& inst, Solution& sol,
+									 const vector<PortfolioWorker>& workers, size_t rounds,
+									 double time_limit);
@@ -0,0 +1,392 @@
+#include "render.hpp"
+#include "cgshop2023_core/profiling.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Ring = vector<pair<double, double>>; // in pixels
+using Color = array<uint8_t, 3>;
+
+// maps instance coordinates to pixels, with y pointing down
+struct View {
+	double xmin, ymax, scale;
+	size_t width, height;
+
+	[[nodiscard]] double px(double x) const { return (x - xmin) * scale; }
+	[[nodiscard]] double py(double y) const { return (ymax - y) * scale; }
+};
+
+// vertices closer than this (in pixels) to the previous one are dropped
+constexpr double LOD_PIXELS = 0.5;
+// Largest image drawn; bigger requests are scaled down to fit. That keeps
+// the canvas at 192 MB and every PNG chunk far below its 32-bit length.
+constexpr size_t MAX_SIDE = 1 << 16;
+constexpr size_t MAX_PIXELS = 1 << 26;
+
+constexpr array<Color, 8> PALETTE = {{{31, 119, 180},
+																		 {255, 127, 14},
+																		 {44, 160, 44},
+																		 {214, 39, 40},
+																		 {148, 103, 189},
+																		 {140, 86, 75},
+																		 {227, 119, 194},
+																		 {23, 190, 207}}};
+constexpr Color DOMAIN_COLOR = {224, 224, 224};
+constexpr Color INK = {0, 0, 0};
+constexpr Color DOT_COLOR = {51, 51, 51};
+constexpr double FILL_ALPHA = 0.3;
+
+// RGB image with the few primitives the renderer needs
+class Canvas {
+public:
+	Canvas(size_t width, size_t height)
+			: m_width(width), m_height(height), m_rgb(width * height * 3, 255),
+				m_crossings(height) {}
+
+	[[nodiscard]] size_t width() const { return m_width; }
+	[[nodiscard]] size_t height() const { return m_height; }
+	[[nodiscard]] const vector<uint8_t>& rgb() const { return m_rgb; }
+
+	void blend(long x, long y, const Color& color, double alpha) {
+		if (x < 0 || y < 0 || size_t(x) >= m_width || size_t(y) >= m_height)
+			return;
+		uint8_t* px = &m_rgb[(size_t(y) * m_width + size_t(x)) * 3];
+		for (size_t k = 0; k < 3; ++k)
+			px[k] = uint8_t(lround(px[k] * (1 - alpha) + color[k] * alpha));
+	}
+
+	// even-odd interior of rings, sampled at the pixel centres
+	void fill(const vector<Ring>& rings, const Color& color, double alpha) {
+		long first = long(m_height), last = 0;
+		for (const Ring& ring : rings)
+			for (size_t k = 0; k < ring.size(); ++k) {
+				auto [x0, y0] = ring[k];
+				auto [x1, y1] = ring[(k + 1) % ring.size()];
+				if (y0 == y1)
+					continue;
+				long r0 = row_at(min(y0, y1)), r1 = row_at(max(y0, y1));
+				for (long r = r0; r < r1; ++r)
+					m_crossings[size_t(r)].push_back(x0 + (r + 0.5 - y0) * (x1 - x0) /
+																									 (y1 - y0));
+				first = min(first, r0);
+				last = max(last, r1);
+			}
+		for (long r = first; r < last; ++r) {
+			auto& xs = m_crossings[size_t(r)];
+			sort(xs.begin(), xs.end());
+			for (size_t k = 0; k + 1 < xs.size(); k += 2) {
+				long c1 = col_at(xs[k + 1]);
+				for (long c = col_at(xs[k]); c < c1; ++c)
+					blend(c, r, color, alpha);
+			}
+			xs.clear();
+		}
+	}
+
+	// segment clipped to the image (Liang-Barsky), then stepped pixel by pixel
+	void line(pair<double, double> a, pair<double, double> b,
+						const Color& color) {
+		double t0 = 0, t1 = 1;
+		double dx = b.first - a.first, dy = b.second - a.second;
+		auto clip = [&](double p, double q) {
+			if (p == 0)
+				return q >= 0;
+			double t = q / p;
+			if (p < 0)
+				t0 = max(t0, t);
+			else
+				t1 = min(t1, t);
+			return t0 <= t1;
+		};
+		if (!clip(-dx, a.first) || !clip(dx, double(m_width) - a.first) ||
+				!clip(-dy, a.second) || !clip(dy, double(m_height) - a.second))
+			return;
+		double x = a.first + t0 * dx, y = a.second + t0 * dy;
+		double steps = ceil(max(abs(dx), abs(dy)) * (t1 - t0));
+		double sx = steps > 0 ? dx * (t1 - t0) / steps : 0;
+		double sy = steps > 0 ? dy * (t1 - t0) / steps : 0;
+		for (double s = 0; s <= steps; ++s, x += sx, y += sy)
+			blend(long(floor(x)), long(floor(y)), color, 1);
+	}
+
+private:
+	// first row (column) whose centre is at or below y (right of x)
+	[[nodiscard]] long row_at(double y) const {
+		return clamp(long(ceil(y - 0.5)), 0L, long(m_height));
+	}
+	[[nodiscard]] long col_at(double x) const {
+		return clamp(long(ceil(x - 0.5)), 0L, long(m_width));
+	}
+
+	size_t m_width, m_height;
+	vector<uint8_t> m_rgb;
+	vector<vector<double>> m_crossings;
+};
+
+} // namespace
+
+static View make_view(const Instance& inst, const RenderOptions& options) {
+	CGAL::Bbox_2 box =
+			options.tile ? *options.tile : inst.polygon().outer_boundary().bbox();
+	double w = max(box.xmax() - box.xmin(), 1e-9);
+	double h = max(box.ymax() - box.ymin(), 1e-9);
+	View view;
+	view.xmin = box.xmin();
+	view.ymax = box.ymax();
+	view.scale = double(max<size_t>(options.width, 1)) / w;
+	// a tall region would otherwise get an unbounded height
+	double fit = min({double(MAX_SIDE) / (w * view.scale),
+										double(MAX_SIDE) / (h * view.scale),
+										sqrt(double(MAX_PIXELS) / (w * h)) / view.scale});
+	if (fit < 1) {
+		view.scale *= fit;
+		cerr << "render: image scaled down to at most " << MAX_PIXELS
+				 << " pixels" << endl;
+	}
+	view.width = fit < 1 ? clamp<size_t>(size_t(ceil(w * view.scale)), 1,
+																		 MAX_SIDE)
+											 : max<size_t>(options.width, 1);
+	view.height = clamp<size_t>(size_t(ceil(h * view.scale)), 1, MAX_SIDE);
+	return view;
+}
+
+// does a box (in instance coordinates) meet the drawn region?
+static bool visible(const CGAL::Bbox_2& box, const View& view) {
+	return view.px(box.xmax()) >= 0 && view.px(box.xmin()) <= view.width &&
+				 view.py(box.ymin()) >= 0 && view.py(box.ymax()) <= view.height;
+}
+
+// smaller than a pixel in both directions, so drawn as one
+static bool sub_pixel(const CGAL::Bbox_2& box, const View& view) {
+	return (box.xmax() - box.xmin()) * view.scale < 1 &&
+				 (box.ymax() - box.ymin()) * view.scale < 1;
+}
+
+// ring in pixels, at the level of detail of the image
+static void project(const SimplePolygon& ring, const View& view, Ring& out) {
+	out.clear();
+	using Pixel = pair<double, double>;
+	auto close = [](const Pixel& a, const Pixel& b) {
+		return abs(a.first - b.first) < LOD_PIXELS &&
+					 abs(a.second - b.second) < LOD_PIXELS;
+	};
+	for (const Point& p : ring) {
+		Pixel q(view.px(CGAL::to_double(p.x())), view.py(CGAL::to_double(p.y())));
+		if (out.empty() || !close(out.back(), q))
+			out.push_back(q);
+	}
+	while (out.size() > 1 && close(out.back(), out.front()))
+		out.pop_back();
+}
+
+// the pixels of the sub-pixel polygons, each once
+static vector<pair<long, long>> dots(const Solution& sol, const View& view) {
+	vector<pair<long, long>> out;
+	for (const auto& poly : sol.polygons()) {
+		CGAL::Bbox_2 box = poly.bbox();
+		if (!visible(box, view) || !sub_pixel(box, view))
+			continue;
+		out.emplace_back(long(floor(view.px(box.xmin()))),
+										 long(floor(view.py(box.ymax()))));
+	}
+	sort(out.begin(), out.end());
+	out.erase(unique(out.begin(), out.end()), out.end());
+	return out;
+}
+
+static void svg_path(ostream& output, const Ring& ring) {
+	output << 'M';
+	for (size_t k = 0; k < ring.size(); ++k)
+		output << (k ? " " : "") << ring[k].first << ' ' << ring[k].second;
+	output << 'Z';
+}
+
+static string hex(const Color& color) {
+	static const char* digits = "0123456789abcdef";
+	string out = "#";
+	for (uint8_t c : color) {
+		out += digits[c >> 4];
+		out += digits[c & 15];
+	}
+	return out;
+}
+
+void render_svg(const Instance& inst, const Solution& sol, ostream& output,
+								const RenderOptions& options) {
+	profiling::ScopedTimer timer("render.svg");
+	View view = make_view(inst, options);
+	auto flags = output.flags();
+	auto precision = output.precision();
+	output << fixed << setprecision(1);
+	output << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << view.width
+				 << "\" height=\"" << view.height << "\" viewBox=\"0 0 " << view.width
+				 << ' ' << view.height << "\">\n";
+	output << "<rect width=\"100%\" height=\"100%\" fill=\"#fff\"/>\n";
+
+	Ring ring;
+	output << "<path fill=\"" << hex(DOMAIN_COLOR)
+				 << "\" fill-rule=\"evenodd\" stroke=\"#000\" d=\"";
+	project(inst.polygon().outer_boundary(), view, ring);
+	svg_path(output, ring);
+	for (const auto& hole : inst.polygon().holes()) {
+		project(hole, view, ring);
+		svg_path(output, ring);
+	}
+	output << "\"/>\n";
+
+	output << "<g fill-opacity=\"" << FILL_ALPHA << "\" stroke-width=\"0.5\">\n";
+	const auto& polys = sol.polygons();
+	for (size_t i = 0; i < polys.size(); ++i) {
+		CGAL::Bbox_2 box = polys[i].bbox();
+		if (!visible(box, view) || sub_pixel(box, view))
+			continue;
+		project(polys[i], view, ring);
+		string color = hex(PALETTE[i % PALETTE.size()]);
+		output << "<path fill=\"" << color << "\" stroke=\"" << color << "\" d=\"";
+		svg_path(output, ring);
+		output << "\"/>\n";
+	}
+	output << "</g>\n";
+
+	auto pixels = dots(sol, view);
+	if (!pixels.empty()) {
+		output << "<path fill=\"" << hex(DOT_COLOR) << "\" d=\"";
+		for (auto [x, y] : pixels)
+			output << 'M' << x << ' ' << y << "h1v1h-1Z";
+		output << "\"/>\n";
+	}
+	output << "</svg>\n";
+	output.flags(flags);
+	output.precision(precision);
+}
+
+static uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+	static const auto table = []() {
+		array<uint32_t, 256> t{};
+		for (uint32_t n = 0; n < 256; ++n) {
+			uint32_t c = n;
+			for (int k = 0; k < 8; ++k)
+				c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			t[n] = c;
+		}
+		return t;
+	}();
+	crc = ~crc;
+	for (size_t k = 0; k < size; ++k)
+		crc = table[(crc ^ data[k]) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+static void put_u32(vector<uint8_t>& out, uint32_t v) {
+	for (int shift = 24; shift >= 0; shift -= 8)
+		out.push_back(uint8_t(v >> shift));
+}
+
+static void png_chunk(ostream& output, const char* type,
+											const vector<uint8_t>& data) {
+	vector<uint8_t> chunk;
+	put_u32(chunk, uint32_t(data.size()));
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+	put_u32(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+	output.write(reinterpret_cast<const char*>(chunk.data()),
+							 std::streamsize(chunk.size()));
+}
+
+// RGB image as PNG, with the pixel data in stored (uncompressed) deflate
+// blocks of a zlib stream
+static void write_png(ostream& output, const Canvas& canvas) {
+	static const uint8_t signature[] = {137, 80, 78, 71, 13, 10, 26, 10};
+	output.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+	vector<uint8_t> header;
+	put_u32(header, uint32_t(canvas.width()));
+	put_u32(header, uint32_t(canvas.height()));
+	header.insert(header.end(), {8, 2, 0, 0, 0}); // 8 bit RGB, no interlace
+	png_chunk(output, "IHDR", header);
+
+	// scanlines, each with filter type 0
+	vector<uint8_t> raw;
+	size_t stride = canvas.width() * 3;
+	raw.reserve((stride + 1) * canvas.height());
+	for (size_t y = 0; y < canvas.height(); ++y) {
+		raw.push_back(0);
+		auto row = canvas.rgb().begin() + std::ptrdiff_t(y * stride);
+		raw.insert(raw.end(), row, row + std::ptrdiff_t(stride));
+	}
+	vector<uint8_t> zlib = {0x78, 0x01};
+	for (size_t pos = 0; pos < raw.size();) {
+		size_t len = min<size_t>(raw.size() - pos, 65535);
+		zlib.push_back(pos + len == raw.size() ? 1 : 0);
+		zlib.push_back(uint8_t(len));
+		zlib.push_back(uint8_t(len >> 8));
+		zlib.push_back(uint8_t(~len));
+		zlib.push_back(uint8_t(~len >> 8));
+		zlib.insert(zlib.end(), raw.begin() + std::ptrdiff_t(pos),
+								raw.begin() + std::ptrdiff_t(pos + len));
+		pos += len;
+	}
+	uint32_t a = 1, b = 0;
+	for (uint8_t v : raw) {
+		a = (a + v) % 65521;
+		b = (b + a) % 65521;
+	}
+	put_u32(zlib, (b << 16) | a);
+	png_chunk(output, "IDAT", zlib);
+	png_chunk(output, "IEND", {});
+}
+
+void render_png(const Instance& inst, const Solution& sol, ostream& output,
+								const RenderOptions& options) {
+	profiling::ScopedTimer timer("render.png");
+	View view = make_view(inst, options);
+	Canvas canvas(view.width, view.height);
+
+	vector<Ring> boundary(1);
+	project(inst.polygon().outer_boundary(), view, boundary[0]);
+	for (const auto& hole : inst.polygon().holes()) {
+		boundary.emplace_back();
+		project(hole, view, boundary.back());
+	}
+	canvas.fill(boundary, DOMAIN_COLOR, 1);
+
+	vector<Ring> rings(1);
+	const auto& polys = sol.polygons();
+	for (size_t i = 0; i < polys.size(); ++i) {
+		CGAL::Bbox_2 box = polys[i].bbox();
+		if (!visible(box, view) || sub_pixel(box, view))
+			continue;
+		project(polys[i], view, rings[0]);
+		const Color& color = PALETTE[i % PALETTE.size()];
+		canvas.fill(rings, color, FILL_ALPHA);
+		const Ring& ring = rings[0];
+		for (size_t k = 0; k < ring.size(); ++k)
+			canvas.line(ring[k], ring[(k + 1) % ring.size()], color);
+	}
+	for (auto [x, y] : dots(sol, view))
+		canvas.blend(x, y, DOT_COLOR, 1);
+	for (const Ring& ring : boundary)
+		for (size_t k = 0; k < ring.size(); ++k)
+			canvas.line(ring[k], ring[(k + 1) % ring.size()], INK);
+	write_png(output, canvas);
+}
+
+void render_file(const Instance& inst, const Solution& sol, const string& path,
+								 const RenderOptions& options) {
+	bool png = path.size() >= 4 && path.compare(path.size() - 4, 4, ".png") == 0;
+	ofstream ofs(path, png ? ios::binary : ios::out);
+	if (!ofs) {
+		cerr << "Could not write rendering to " << path << endl;
+		return;
+	}
+	if (png)
+		render_png(inst, sol, ofs, options);
+	else
+		render_svg(inst, sol, ofs, options);
+}
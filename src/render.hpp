@@ -0,0 +1,37 @@
+#pragma once
+
+#include "cgshop2023_core/cpp_instance.hpp"
+#include <CGAL/Bbox_2.h>
+#include <cstddef>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace cgshop2023;
+using namespace std;
+
+struct RenderOptions {
+	// width of the image in pixels, the height follows from the drawn region;
+	// both are scaled down if the image would exceed 2^16 pixels on a side or
+	// 2^26 pixels in total
+	size_t width = 2048;
+	// region to draw (in instance coordinates), default the whole instance
+	optional<CGAL::Bbox_2> tile;
+};
+
+// Headless rendering of an instance and a cover, streamed to the output
+// without a window system. Polygons outside the drawn region are culled by
+// their bounding boxes; the others are drawn at the level of detail of the
+// image: vertices closer than half a pixel to the previous one are dropped,
+// and polygons smaller than a pixel become (deduplicated) single pixels. That
+// keeps even covers of 100k polygons to seconds and to files of a few MB.
+void render_svg(const Instance& inst, const Solution& sol, ostream& output,
+								const RenderOptions& options = {});
+
+// the same as an RGB PNG (uncompressed, so no zlib is needed)
+void render_png(const Instance& inst, const Solution& sol, ostream& output,
+								const RenderOptions& options = {});
+
+// render_png if path ends in .png, render_svg otherwise
+void render_file(const Instance& inst, const Solution& sol,
+								 const string& path, const RenderOptions& options = {});
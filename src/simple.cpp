@@ -1,12 +1,19 @@
 #include <bits/stdc++.h>
 
+#include "annealing.hpp"
 #include "cgshop2023_core/cpp_instance.hpp"
+#include "cgshop2023_core/lower_bound.hpp"
+#include "cgshop2023_core/profiling.hpp"
 #include "cgshop2023_core/verify.hpp"
-//#include "draw_solution.hpp"
+#include "committer.hpp"
+#include "daemon.hpp"
 #include "globals.hpp"
 #include "localsearch.hpp"
+#include "pipeline.hpp"
+#include "portfolio.hpp"
+#include "render.hpp"
 #include "triangulation.hpp"
-//#include <CGAL/draw_polygon_with_holes_2.h>
+#include "work_queue.hpp"
 
 using namespace cgshop2023;
 using namespace std;
@@ -45,6 +52,23 @@ int main(int argc, char* argv[]) {
 	bool localsearch = false;
 	size_t removal_attempts = 0;
 	size_t replacement_choices = 0;
+	size_t shrink_rounds = 0;
+	bool annealing = false;
+	AnnealConfig anneal_config;
+	size_t portfolio = 0;
+	size_t portfolio_rounds = 0;
+	double portfolio_time = 0;
+	bool daemon = false;
+	size_t cache_mb = 4096;
+	string metrics_dir;
+	size_t prefetch = 0;
+	string render_dir;
+	string history_dir;
+	size_t shard = 0, num_shards = 1;
+	string queue_dir;
+	double lease_seconds = 300;
+	string render_format = "svg";
+	RenderOptions render_options;
 	for (int i = 1; i < argc; ++i) {
 		string cur(argv[i]);
 		auto eq = [&](const auto& a) { return cur == string(a); };
@@ -52,7 +76,26 @@ int main(int argc, char* argv[]) {
 		if (eq("-h") || eq("--help")) {
 			cerr << "Example usage: ls instances | build/simple --order-by-size "
 							"--localsearch --randomize --num-threads 3 --removal-attempts "
-							"100 --replacement-choices 100"
+							"100 --replacement-choices 100 --shrink-rounds 5 --anneal "
+							"--anneal-time 60 --portfolio 4 --portfolio-time 600 "
+							"--visibility --multi-absorb --simplify-rationals --prefetch 4 "
+							"--history history --metrics metrics"
+					 << endl;
+			cerr << "Add --tri-cache <dir> to keep the preprocessed instances of "
+							"--init (triangulation, lower bound) for later runs"
+					 << endl;
+			cerr << "Rendering: add --render images [--render-format png] "
+							"[--render-width 4096] [--render-tile xmin,ymin,xmax,ymax] "
+							"to draw every processed solution, or use it alone to draw "
+							"the saved ones"
+					 << endl;
+			cerr << "Several processes or nodes: add --shard i/N to take every "
+							"N-th instance, or --queue-dir <shared dir> [--lease-seconds "
+							"300] to claim instances dynamically"
+					 << endl;
+			cerr << "Daemon usage: build/simple --daemon --cache-mb 8192, then "
+							"send lines like 'improve <instance> <seconds> [anneal] "
+							"[lahc=N] [shrink=N] [choices=N] [portfolio=K]' on stdin"
 					 << endl;
 		} else if (eq("--order-by-size"))
 			orderBySize = true;
@@ -68,6 +111,80 @@ int main(int argc, char* argv[]) {
 			removal_attempts = stoi(next());
 		else if (eq("--replacement-choices"))
 			replacement_choices = stoi(next());
+		else if (eq("--shrink-rounds"))
+			shrink_rounds = stoi(next());
+		else if (eq("--anneal"))
+			annealing = true;
+		else if (eq("--anneal-iterations"))
+			anneal_config.iterations = stoul(next());
+		else if (eq("--anneal-time"))
+			anneal_config.time_limit = stod(next());
+		else if (eq("--lahc"))
+			anneal_config.history_length = stoul(next());
+		else if (eq("--split-probability"))
+			anneal_config.split_probability = stod(next());
+		else if (eq("--start-temperature"))
+			anneal_config.start_temperature = stod(next());
+		else if (eq("--end-temperature"))
+			anneal_config.end_temperature = stod(next());
+		else if (eq("--linear-cooling"))
+			anneal_config.schedule = CoolingSchedule::Linear;
+		else if (eq("--area-weight"))
+			anneal_config.area_weight = stod(next());
+		else if (eq("--portfolio"))
+			portfolio = stoul(next());
+		else if (eq("--portfolio-rounds"))
+			portfolio_rounds = stoul(next());
+		else if (eq("--portfolio-time"))
+			portfolio_time = stod(next());
+		else if (eq("--daemon"))
+			daemon = true;
+		else if (eq("--cache-mb"))
+			cache_mb = stoul(next());
+		else if (eq("--prefetch"))
+			prefetch = stoul(next());
+		else if (eq("--shard")) {
+			string spec = next();
+			size_t slash = spec.find('/');
+			if (slash != string::npos) {
+				shard = stoul(spec.substr(0, slash));
+				num_shards = max<size_t>(stoul(spec.substr(slash + 1)), 1);
+			}
+			if (slash == string::npos || shard >= num_shards) {
+				cerr << "Expected --shard i/N with 0 <= i < N" << endl;
+				return 1;
+			}
+		} else if (eq("--queue-dir"))
+			queue_dir = next();
+		else if (eq("--lease-seconds"))
+			lease_seconds = stod(next());
+		else if (eq("--history"))
+			history_dir = next();
+		else if (eq("--render"))
+			render_dir = next();
+		else if (eq("--render-format"))
+			render_format = next();
+		else if (eq("--render-width"))
+			render_options.width = stoul(next());
+		else if (eq("--render-tile")) {
+			double xmin, ymin, xmax, ymax;
+			char sep;
+			istringstream tile(next());
+			if (tile >> xmin >> sep >> ymin >> sep >> xmax >> sep >> ymax)
+				render_options.tile = CGAL::Bbox_2(xmin, ymin, xmax, ymax);
+			else
+				cerr << "Expected --render-tile xmin,ymin,xmax,ymax" << endl;
+		} else if (eq("--metrics"))
+			metrics_dir = next();
+		else if (eq("--tri-cache")) {
+			TRIANGULATION_CACHE = next();
+			filesystem::create_directories(TRIANGULATION_CACHE);
+		} else if (eq("--visibility"))
+			VISIBILITY_PRUNING = true;
+		else if (eq("--multi-absorb"))
+			MULTI_ABSORB = true;
+		else if (eq("--simplify-rationals"))
+			SIMPLIFY_RATIONALS = true;
 		else if (eq("--verbose") || eq("-v"))
 			VERBOSE = true;
 		else {
@@ -75,6 +192,52 @@ int main(int argc, char* argv[]) {
 		}
 	}
 
+	if (replacement_choices > 0)
+		anneal_config.replacement_choices = replacement_choices;
+
+	PortfolioWorker base_worker;
+	base_worker.randomize = randomize;
+	base_worker.removal_attempts = removal_attempts;
+	base_worker.replacement_choices = replacement_choices;
+	base_worker.shrink_rounds = shrink_rounds;
+	base_worker.annealing = annealing;
+	base_worker.anneal_config = anneal_config;
+
+	profiling::enabled = !metrics_dir.empty();
+	// wraps the processing of one instance to collect and write its metrics
+	auto profiled = [&](function<void(string)> process_file) {
+		return [&, process_file](string filename) {
+			if (!profiling::enabled) {
+				process_file(filename);
+				return;
+			}
+			profiling::take();
+			auto start = chrono::steady_clock::now();
+			process_file(filename);
+			double wall =
+					chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			profiling::write_report(metrics_dir, filename, profiling::take(), wall);
+		};
+	};
+
+	auto improve = [&](Instance& inst, Solution& sol) {
+		if (portfolio > 0) {
+			run_portfolio(inst, sol, make_portfolio(portfolio, base_worker),
+										portfolio_rounds, portfolio_time);
+			return;
+		}
+		if (localsearch)
+			try_remove_all(inst, sol, randomize, removal_attempts,
+										 replacement_choices, shrink_rounds);
+		if (annealing)
+			anneal(inst, sol, anneal_config);
+	};
+
+	if (daemon) {
+		run_daemon(cin, cout, cache_mb << 20);
+		return 0;
+	}
+
 	string filename;
 	vector<string> files;
 	while (cin >> filename) {
@@ -100,35 +263,109 @@ int main(int argc, char* argv[]) {
 		cerr << "Finished sorting\n";
 	}
 
-	if (init) {
-		use_threads(files, num_threads, [&](string filename) {
-			Instance inst = Instance::read_file(filename);
-			Solution oldsol = Solution::read_file(filename);
-			size_t original_size = oldsol.size();
-			Solution sol = basicTriangulation(inst);
-			if (localsearch) {
-				try_remove_all(inst, sol, randomize, removal_attempts,
-											 replacement_choices);
-			}
-			if (!sol.write_if_better(inst, filename)) {
-				cerr << "Did not see improvement to " << filename
-						 << " (previous:" << original_size << ", new:" << sol.size() << ")"
-						 << endl;
-			}
-		});
-	} else if (localsearch) {
-		use_threads(files, num_threads, [&](string filename) {
-			Instance inst = Instance::read_file(filename);
-			Solution sol = Solution::read_file(filename);
-			size_t original_size = sol.size();
-			try_remove_all(inst, sol, randomize, removal_attempts,
-										 replacement_choices);
-			if (!sol.write_if_better(inst, filename)) {
-				cerr << "Did not see improvement to " << filename
-						 << " (previous:" << original_size << ", new:" << sol.size() << ")"
-						 << endl;
-			}
-		});
+	if (num_shards > 1) {
+		// every N-th file, after sorting, so shards get similar mixes of sizes
+		vector<string> mine;
+		for (size_t i = shard; i < files.size(); i += num_shards)
+			mine.push_back(files[i]);
+		files = std::move(mine);
+		cerr << "Shard " << shard << "/" << num_shards << ": " << files.size()
+				 << " files" << endl;
+	}
+
+	bool improving = init || localsearch || annealing || portfolio > 0;
+	PipelineStages stages;
+	stages.load = [&](PipelineJob& job) {
+		job.inst = make_shared<Instance>(Instance::read_file(job.name));
+		job.sol = Solution::read_file(job.name);
+	};
+	stages.compute = [&](PipelineJob& job) {
+		if (init)
+			job.sol = basicTriangulation(*job.inst);
+		improve(*job.inst, job.sol);
+		if (!improving)
+			return;
+		size_t bound = cover_lower_bound(*job.inst);
+		size_t gap = job.sol.size() - min(bound, job.sol.size());
+		cerr << job.name << ": " << job.sol.size() << " polygons, lower bound "
+				 << bound << ", gap " << gap << endl;
+		profiling::count("lower_bound.bound", bound);
+		profiling::count("lower_bound.gap", gap);
+	};
+	if (!history_dir.empty())
+		filesystem::create_directories(history_dir);
+	if (!render_dir.empty())
+		filesystem::create_directories(render_dir);
+	// declared before the committer, whose pending commits release entries
+	unique_ptr<WorkQueue> queue;
+	SolutionCommitter committer{SolutionStore(history_dir)};
+	stages.write = [&](PipelineJob& job) {
+		if (!render_dir.empty())
+			render_file(*job.inst, job.sol,
+									render_dir + "/" + job.name + "." + render_format,
+									render_options);
+		if (!improving)
+			return;
+		function<void(bool)> on_saved;
+		if (queue)
+			// the instance is only done once its cover is saved
+			on_saved = [&queue, name = job.name](bool saved) {
+				queue->release(name, saved);
+			};
+		committer.submit(make_shared<const Instance>(job.inst->deep_copy()),
+										 job.name, job.sol.deep_copy(), std::move(on_saved));
+	};
+	stages.finished = [&](const PipelineJob& job) {
+		if (profiling::enabled)
+			profiling::write_report(metrics_dir, job.name, job.stats, job.seconds);
+	};
+	if (!queue_dir.empty()) {
+		queue = make_unique<WorkQueue>(queue_dir, lease_seconds);
+		stages.claim = [&](const string& name) { return queue->claim(name); };
+		stages.release = [&](const string& name, bool done) {
+			// a submitted cover releases its entry when it has been committed
+			// (see stages.write), without holding up the pipeline
+			if (!done || !improving)
+				queue->release(name, done);
+		};
+	}
+
+	if (!improving && render_dir.empty())
+		return 0;
+	auto run_all = [&]() {
+		if (prefetch > 0) {
+			run_pipeline(files, num_threads, prefetch, stages);
+		} else {
+			use_threads(files, num_threads, profiled([&](string filename) {
+				if (stages.claim && !stages.claim(filename))
+					return;
+				PipelineJob job;
+				job.name = filename;
+				stages.load(job);
+				stages.compute(job);
+				stages.write(job);
+				if (stages.release)
+					stages.release(filename, true);
+			}));
+		}
+		committer.flush();
+	};
+	run_all();
+	if (queue) {
+		// instances that failed here or in other workers have had their leases
+		// released without being done, walk them once more
+		cerr << "Queue: retrying unfinished instances" << endl;
+		run_all();
+	}
+	auto commits = committer.stats();
+	cerr << "Committed " << commits.written << " of " << commits.submitted
+			 << " solutions (" << commits.coalesced << " coalesced, "
+			 << commits.rejected << " rejected)" << endl;
+	if (queue) {
+		auto claims = queue->stats();
+		cerr << "Queue: claimed " << claims.claimed << " instances ("
+				 << claims.reclaimed << " from dead workers), skipped "
+				 << claims.skipped << endl;
 	}
 
 	// old
@@ -146,7 +383,7 @@ int main(int argc, char* argv[]) {
 		// basicTriangulation(inst);
 		// draw(inst, sol);
 		try_remove_all(inst, sol);
-		SolutionVerifier sv(&inst, &sol);
+		SolutionVerifier sv(&inst, &sol, num_threads);
 		cerr << "Verify result: " << (sv.verify() ? "success" : "failed (invalid)")
 				 << endl;
 		if (sv.error_message().has_value()) {
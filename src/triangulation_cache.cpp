@@ -0,0 +1,186 @@
+#include "triangulation_cache.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+constexpr char MAGIC[8] = {'C', 'G', 'S', 'T', 'R', 'I', '\n', '\0'};
+// bump whenever the layout or the triangulation itself changes
+constexpr uint32_t VERSION = 2;
+// written as is, so files from a host of the other byte order do not match
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// followed by the ring sizes (uint64_t[num_rings], outer boundary first), the
+// vertices (IntPoint[num_vertices]) and the domain triangles
+// (CachedFace[num_faces])
+struct Header {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint64_t key;
+	uint64_t num_rings;
+	uint64_t num_vertices;
+	uint64_t num_faces;
+	uint64_t lower_bound;
+};
+static_assert(sizeof(Header) == 56 && sizeof(IntPoint) == 16 &&
+							sizeof(CachedFace) == 12);
+
+// the ring sizes and instance vertices in cache order, false if some vertices
+// are not integers
+bool int_vertices(const Instance& inst, vector<uint64_t>& rings,
+									vector<IntPoint>& out) {
+	if (!inst.boundary().valid())
+		return false;
+	rings.clear();
+	out.clear();
+	out.reserve(inst.num_vertices());
+	auto add_ring = [&](const SimplePolygon& ring) {
+		rings.push_back(ring.size());
+		for (const auto& p : ring.container()) {
+			out.emplace_back();
+			if (!to_int_point(p, out.back()))
+				return false;
+		}
+		return true;
+	};
+	if (!add_ring(inst.polygon().outer_boundary()))
+		return false;
+	for (const auto& hole : inst.polygon().holes())
+		if (!add_ring(hole))
+			return false;
+	return true;
+}
+
+// FNV-1a over the ring sizes and the vertices
+uint64_t instance_key(const vector<uint64_t>& rings,
+											const vector<IntPoint>& vertices) {
+	uint64_t hash = 0xcbf29ce484222325;
+	auto mix = [&](const void* data, size_t size) {
+		auto bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= bytes[i];
+			hash *= 0x100000001b3;
+		}
+	};
+	mix(rings.data(), rings.size() * sizeof(uint64_t));
+	mix(vertices.data(), vertices.size() * sizeof(IntPoint));
+	return hash;
+}
+
+string cache_path(const string& dir, uint64_t key) {
+	ostringstream path;
+	path << dir << "/" << hex << setw(16) << setfill('0') << key << ".tri";
+	return path.str();
+}
+
+} // namespace
+
+TriangulationCache::~TriangulationCache() {
+	if (m_data)
+		munmap(m_data, m_size);
+}
+
+unique_ptr<TriangulationCache> TriangulationCache::open(const string& dir,
+																												const Instance& inst) {
+	vector<uint64_t> rings;
+	vector<IntPoint> vertices;
+	if (!int_vertices(inst, rings, vertices))
+		return nullptr;
+	uint64_t key = instance_key(rings, vertices);
+	int fd = ::open(cache_path(dir, key).c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return nullptr;
+	struct stat st;
+	unique_ptr<TriangulationCache> cache(new TriangulationCache());
+	if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(Header)) {
+		void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED) {
+			cache->m_data = data;
+			cache->m_size = st.st_size;
+		}
+	}
+	close(fd);
+	if (!cache->m_data)
+		return nullptr;
+
+	auto base = static_cast<const char*>(cache->m_data);
+	Header header;
+	memcpy(&header, base, sizeof(header));
+	if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+			header.version != VERSION || header.byte_order != BYTE_ORDER_MARK ||
+			header.key != key || header.num_rings != rings.size() ||
+			header.num_vertices != vertices.size())
+		return nullptr;
+	size_t ring_bytes = rings.size() * sizeof(uint64_t);
+	size_t vertex_bytes = vertices.size() * sizeof(IntPoint);
+	size_t faces_offset = sizeof(Header) + ring_bytes + vertex_bytes;
+	if (cache->m_size != faces_offset + header.num_faces * sizeof(CachedFace))
+		return nullptr;
+	if (memcmp(base + sizeof(Header), rings.data(), ring_bytes) != 0 ||
+			memcmp(base + sizeof(Header) + ring_bytes, vertices.data(),
+						 vertex_bytes) != 0)
+		return nullptr;
+	cache->m_faces = reinterpret_cast<const CachedFace*>(base + faces_offset);
+	cache->m_num_faces = header.num_faces;
+	cache->m_lower_bound = header.lower_bound;
+	// a truncated or garbled file must not send anyone out of bounds
+	for (size_t i = 0; i < cache->m_num_faces; ++i)
+		for (uint32_t v : cache->m_faces[i].v)
+			if (v >= vertices.size())
+				return nullptr;
+	return cache;
+}
+
+void TriangulationCache::store(const string& dir, const Instance& inst,
+															 const vector<CachedFace>& faces,
+															 size_t lower_bound) {
+	vector<uint64_t> rings;
+	vector<IntPoint> vertices;
+	if (!int_vertices(inst, rings, vertices))
+		return;
+	Header header;
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.byte_order = BYTE_ORDER_MARK;
+	header.key = instance_key(rings, vertices);
+	header.num_rings = rings.size();
+	header.num_vertices = vertices.size();
+	header.num_faces = faces.size();
+	header.lower_bound = lower_bound;
+
+	// same write-then-rename as Solution::write_to, the directory may be shared
+	string path = cache_path(dir, header.key);
+	char host[256] = "";
+	gethostname(host, sizeof(host) - 1);
+	auto thread = hash<std::thread::id>{}(this_thread::get_id());
+	string tmp_name = path + ".tmp" + host + "-" + to_string(getpid()) + "-" +
+										to_string(thread);
+	{
+		ofstream ofs(tmp_name, ios::binary);
+		ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		ofs.write(reinterpret_cast<const char*>(rings.data()),
+							rings.size() * sizeof(uint64_t));
+		ofs.write(reinterpret_cast<const char*>(vertices.data()),
+							vertices.size() * sizeof(IntPoint));
+		ofs.write(reinterpret_cast<const char*>(faces.data()),
+							faces.size() * sizeof(CachedFace));
+		if (!ofs.flush()) {
+			error_code ignored;
+			filesystem::remove(tmp_name, ignored);
+			throw runtime_error("could not write " + tmp_name);
+		}
+	}
+	filesystem::rename(tmp_name, path);
+}
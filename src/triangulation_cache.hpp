@@ -0,0 +1,53 @@
+#pragma once
+
+#include "cgshop2023_core/cpp_instance.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace cgshop2023;
+using namespace std;
+
+// A triangle of the domain: indices of its vertices (the instance vertices,
+// outer boundary first, then the holes, in file order).
+struct CachedFace {
+	uint32_t v[3];
+};
+
+// Preprocessed instance, kept in a versioned binary file per instance in a
+// cache directory and read back through mmap, so repeated runs on an instance
+// skip the triangulation, the domain marking and the lower bound. Files are
+// named by the FNV-1a hash of the instance's ring sizes and vertices and also
+// hold both themselves, so a hash collision or a file from an older version is
+// just a miss. Only instances with integer vertices (Instance::boundary) are
+// cached.
+class TriangulationCache {
+public:
+	TriangulationCache(const TriangulationCache&) = delete;
+	TriangulationCache& operator=(const TriangulationCache&) = delete;
+	~TriangulationCache();
+
+	// the cache file of inst in dir, or nullptr if there is no usable one
+	static unique_ptr<TriangulationCache> open(const string& dir,
+																						 const Instance& inst);
+
+	// write (or replace) the cache file of inst in dir, atomically; throws if
+	// the file cannot be written
+	static void store(const string& dir, const Instance& inst,
+										const vector<CachedFace>& faces, size_t lower_bound);
+
+	[[nodiscard]] size_t num_faces() const { return m_num_faces; }
+	[[nodiscard]] const CachedFace& face(size_t i) const { return m_faces[i]; }
+	[[nodiscard]] size_t lower_bound() const { return m_lower_bound; }
+
+private:
+	TriangulationCache() = default;
+
+	void* m_data = nullptr;
+	size_t m_size = 0;
+	const CachedFace* m_faces = nullptr;
+	size_t m_num_faces = 0;
+	size_t m_lower_bound = 0;
+};
@@ -0,0 +1,141 @@
+#include "visibility.hpp"
+#include "cgshop2023_core/profiling.hpp"
+#include <memory>
+
+VisibilityService::VisibilityService(const Instance& inst)
+		: m_instance(inst.id()) {
+	profiling::ScopedTimer timer("visibility.build");
+	vector<Segment> segments;
+	auto add_ring = [&](const SimplePolygon& ring) {
+		for (auto e = ring.edges_begin(); e != ring.edges_end(); ++e)
+			segments.emplace_back(e->source(), e->target());
+	};
+	auto index_ring = [&](const SimplePolygon& ring) {
+		for (const Point& p : ring) {
+			IntPoint q;
+			if (to_int_point(p, q))
+				m_vertex_index.emplace(make_pair(q.x, q.y), m_vertex_index.size());
+		}
+	};
+	add_ring(inst.polygon().outer_boundary());
+	index_ring(inst.polygon().outer_boundary());
+	for (const auto& hole : inst.polygon().holes()) {
+		add_ring(hole);
+		index_ring(hole);
+	}
+	m_regions.resize(m_vertex_index.size());
+	// the boundary of a valid instance does not intersect itself
+	CGAL::insert_non_intersecting_curves(m_env, segments.begin(),
+																			 segments.end());
+	// the interior is the face on the inner side of the outer boundary, which
+	// is the only hole of the unbounded face
+	auto outer = *m_env.unbounded_face()->holes_begin();
+	m_interior = outer->twin()->face();
+	m_location.attach(m_env);
+	m_visibility.attach(m_env);
+}
+
+VisibilityService& VisibilityService::for_instance(const Instance& inst) {
+	thread_local unique_ptr<VisibilityService> service;
+	if (!service || service->m_instance != inst.id())
+		service = make_unique<VisibilityService>(inst);
+	return *service;
+}
+
+const VisibilityService::Region& VisibilityService::lookup(const Point& p) {
+	IntPoint q;
+	auto it = m_vertex_index.end();
+	if (to_int_point(p, q))
+		it = m_vertex_index.find(make_pair(q.x, q.y));
+	if (it == m_vertex_index.end()) {
+		m_scratch = compute(p);
+		return m_scratch;
+	}
+	optional<Region>& slot = m_regions[it->second];
+	if (slot) {
+		profiling::count("visibility.hits");
+		return *slot;
+	}
+	Region region = compute(p);
+	if (m_cached_vertices + region.polygon.size() > MAX_CACHED_VERTICES) {
+		// full: start over rather than track recency, regions are cheap to
+		// recompute compared to the search they save
+		for (auto& r : m_regions)
+			r.reset();
+		m_cached = m_cached_vertices = 0;
+		profiling::count("visibility.flushes");
+	}
+	m_cached_vertices += region.polygon.size();
+	++m_cached;
+	slot = std::move(region);
+	return *slot;
+}
+
+VisibilityService::Region VisibilityService::compute(const Point& p) {
+	profiling::ScopedTimer timer("visibility.compute");
+	using Face = SimpleArrangement::Face_const_handle;
+	using Halfedge = SimpleArrangement::Halfedge_const_handle;
+	using Vertex = SimpleArrangement::Vertex_const_handle;
+	SimpleArrangement out;
+	auto located = m_location.locate(p);
+	if (const Face* f = boost::get<Face>(&located)) {
+		if (*f == m_interior)
+			m_visibility.compute_visibility(p, *f, out);
+	} else if (const Halfedge* e = boost::get<Halfedge>(&located)) {
+		// p is in the interior of a boundary edge, look into the instance
+		Halfedge inward = (*e)->face() == m_interior ? *e : (*e)->twin();
+		m_visibility.compute_visibility(p, inward, out);
+	} else if (const Vertex* v = boost::get<Vertex>(&located)) {
+		// p is an instance vertex: use the edge into it that has the interior
+		// on its left, so the region is the one between it and its successor
+		auto circ = (*v)->incident_halfedges();
+		auto start = circ;
+		while (circ->face() != m_interior && ++circ != start)
+			;
+		m_visibility.compute_visibility(p, Halfedge(circ), out);
+	}
+
+	Region region;
+	for (auto f = out.faces_begin(); f != out.faces_end(); ++f) {
+		if (f->is_unbounded())
+			continue;
+		auto first = f->outer_ccb();
+		auto cur = first;
+		do {
+			region.polygon.push_back(cur->source()->point());
+		} while (++cur != first);
+		break;
+	}
+	// an empty region (p outside the instance) sees nothing
+	region.box = region.polygon.is_empty() ? CGAL::Bbox_2()
+																				 : region.polygon.bbox();
+	return region;
+}
+
+const SimplePolygon& VisibilityService::region(const Point& p) {
+	return lookup(p).polygon;
+}
+
+vector<VisibilityService::Region>
+VisibilityService::regions(const vector<Point>& points) {
+	vector<Region> result;
+	result.reserve(points.size());
+	for (const Point& p : points)
+		result.push_back(lookup(p));
+	return result;
+}
+
+bool VisibilityService::sees_all(const vector<Region>& regions,
+																 const SimplePolygon& poly) {
+	for (const Region& region : regions) {
+		if (region.polygon.is_empty())
+			return false;
+		for (const Point& q : poly) {
+			// boxes are conservative, so only disjoint ones decide anything
+			if (!CGAL::do_overlap(q.bbox(), region.box) ||
+					region.polygon.bounded_side(q) == CGAL::ON_UNBOUNDED_SIDE)
+				return false;
+		}
+	}
+	return true;
+}
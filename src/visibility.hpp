@@ -0,0 +1,73 @@
+#pragma once
+
+#include "cgshop2023_core/arrangement_util.hpp"
+#include "cgshop2023_core/cpp_instance.hpp"
+#include <CGAL/Bbox_2.h>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+using namespace cgshop2023;
+using namespace std;
+
+// Visibility regions inside an instance, computed by triangular expansion on
+// the arrangement of its boundary. Regions of instance vertices are memoized
+// by vertex index, up to MAX_CACHED_VERTICES region vertices in total; other
+// points (vertices constructed during the search) are computed on demand. A
+// polygon can only absorb a point if every one of its vertices sees that
+// point, so try_removal uses these regions to skip hopeless replacement
+// candidates before any hull or Boolean work.
+// Not thread safe; every search thread gets its own service (for_instance).
+class VisibilityService {
+public:
+	// cap on the memoized regions, counted in region vertices
+	static constexpr size_t MAX_CACHED_VERTICES = size_t(1) << 18;
+
+	explicit VisibilityService(const Instance& inst);
+	VisibilityService(const VisibilityService&) = delete;
+	VisibilityService& operator=(const VisibilityService&) = delete;
+
+	// The service of the calling thread for inst, kept for as long as the
+	// thread keeps working on that instance, so regions are reused by every
+	// removal pass, annealing move and daemon job on it.
+	static VisibilityService& for_instance(const Instance& inst);
+
+	// the closed region of the instance that p (a point of the instance)
+	// sees; valid until the next call
+	const SimplePolygon& region(const Point& p);
+
+	struct Region {
+		SimplePolygon polygon;
+		CGAL::Bbox_2 box;
+	};
+
+	// the regions of points, to test several polygons against them
+	vector<Region> regions(const vector<Point>& points);
+
+	// does every vertex of poly see every point whose regions are given?
+	static bool sees_all(const vector<Region>& regions,
+											 const SimplePolygon& poly);
+
+	// number of memoized regions
+	[[nodiscard]] size_t cached() const { return m_cached; }
+
+private:
+
+	const Region& lookup(const Point& p);
+	Region compute(const Point& p);
+
+	std::uint64_t m_instance;
+	SimpleArrangement m_env;
+	SimpleArrangement::Face_const_handle m_interior;
+	SimpleLocation m_location;
+	Visibility m_visibility;
+	// index of every instance vertex, by its integer coordinates
+	map<pair<std::int64_t, std::int64_t>, size_t> m_vertex_index;
+	vector<optional<Region>> m_regions;
+	size_t m_cached = 0;
+	size_t m_cached_vertices = 0;
+	// region of the last point that is not an instance vertex
+	Region m_scratch;
+};
@@ -0,0 +1,125 @@
+#include "work_queue.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static string owner_tag() {
+	char host[256] = "";
+	gethostname(host, sizeof(host) - 1);
+	return string(host) + "-" + to_string(getpid());
+}
+
+WorkQueue::WorkQueue(string dir, double lease_seconds)
+		: m_dir(std::move(dir)), m_lease_seconds(lease_seconds),
+			m_owner(owner_tag()), m_heartbeat([this]() { heartbeat(); }) {
+	filesystem::create_directories(m_dir);
+}
+
+WorkQueue::~WorkQueue() {
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	m_heartbeat.join();
+	for (const string& name : m_held)
+		unlink(path(name, ".lease").c_str());
+}
+
+string WorkQueue::path(const string& name, const char* ext) const {
+	return m_dir + "/" + name + ext;
+}
+
+bool WorkQueue::stale(const string& lease) const {
+	struct stat st;
+	if (stat(lease.c_str(), &st) != 0)
+		return false; // gone already, the next O_EXCL decides
+	return difftime(time(nullptr), st.st_mtime) > m_lease_seconds;
+}
+
+bool WorkQueue::claim(const string& name) {
+	string lease = path(name, ".lease"), done = path(name, ".done");
+	auto skip = [&]() {
+		lock_guard<mutex> lock(m_mutex);
+		++m_stats.skipped;
+		return false;
+	};
+	if (filesystem::exists(done))
+		return skip();
+	for (int attempt = 0; attempt < 2; ++attempt) {
+		int fd = open(lease.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+		if (fd >= 0) {
+			string owner = m_owner + "\n";
+			(void)!write(fd, owner.data(), owner.size());
+			close(fd);
+			// the previous holder may have finished in the meantime
+			if (filesystem::exists(done)) {
+				unlink(lease.c_str());
+				return skip();
+			}
+			lock_guard<mutex> lock(m_mutex);
+			m_held.insert(name);
+			++m_stats.claimed;
+			return true;
+		}
+		if (errno != EEXIST)
+			throw runtime_error("could not create " + lease + ": " +
+													strerror(errno));
+		if (!stale(lease))
+			break;
+		// move the dead worker's lease aside; of several processes doing that
+		// at once only one rename succeeds
+		string grave = lease + ".stale-" + m_owner;
+		if (rename(lease.c_str(), grave.c_str()) == 0) {
+			if (!stale(grave)) {
+				// lost a race against a fresh claim: put that lease back
+				if (link(grave.c_str(), lease.c_str()) != 0)
+					cerr << "queue: lease of " << name << " was lost in a race" << endl;
+				unlink(grave.c_str());
+				break;
+			}
+			unlink(grave.c_str());
+			cerr << "queue: reclaiming " << name << " from a dead worker" << endl;
+			lock_guard<mutex> lock(m_mutex);
+			++m_stats.reclaimed;
+		}
+	}
+	return skip();
+}
+
+void WorkQueue::release(const string& name, bool done) {
+	if (done) {
+		ofstream marker(path(name, ".done"));
+		marker << m_owner << endl;
+	}
+	unlink(path(name, ".lease").c_str());
+	lock_guard<mutex> lock(m_mutex);
+	m_held.erase(name);
+}
+
+WorkQueue::Stats WorkQueue::stats() const {
+	lock_guard<mutex> lock(m_mutex);
+	return m_stats;
+}
+
+// renew the held leases three times per lease period
+void WorkQueue::heartbeat() {
+	auto period = chrono::duration<double>(m_lease_seconds / 3);
+	unique_lock<mutex> lock(m_mutex);
+	while (!m_wake.wait_for(lock, period, [&]() { return m_stop; })) {
+		for (const string& name : m_held) {
+			string lease = path(name, ".lease");
+			if (utimensat(AT_FDCWD, lease.c_str(), nullptr, 0) != 0)
+				cerr << "queue: could not renew the lease of " << name << ": "
+						 << strerror(errno) << endl;
+		}
+	}
+}
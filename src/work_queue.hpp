@@ -0,0 +1,63 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+// File-based work queue in a directory shared by all processes of a batch, on
+// one host or on several nodes with a shared filesystem. Every process walks
+// the same instance list and claims instances one at a time:
+//   <dir>/<name>.lease  created with O_EXCL by the claiming process, and
+//                       touched by its heartbeat thread while it works
+//   <dir>/<name>.done   written once the instance is finished
+// A lease whose mtime is older than lease_seconds belongs to a dead worker and
+// is reclaimed by the next process that wants the instance (the hosts' clocks
+// have to roughly agree). In the rare race of two processes reclaiming the
+// same lease both may end up working on the instance, which the solution
+// store makes harmless. An instance released without being done is free to
+// be claimed again right away, so callers walk their list once more at the end
+// to retry failures. Use a fresh directory for every batch.
+class WorkQueue {
+public:
+	explicit WorkQueue(string dir, double lease_seconds = 300);
+	WorkQueue(const WorkQueue&) = delete;
+	WorkQueue& operator=(const WorkQueue&) = delete;
+	// gives up the leases still held
+	~WorkQueue();
+
+	// Is name neither done nor leased by a live worker? Then it is leased to
+	// this process until release.
+	bool claim(const string& name);
+
+	// drop the lease on name, marking it done or leaving it to be claimed
+	// again; safe to call from any thread
+	void release(const string& name, bool done);
+
+	struct Stats {
+		size_t claimed = 0;
+		size_t reclaimed = 0; // from dead workers
+		size_t skipped = 0;   // done or leased by others
+	};
+	[[nodiscard]] Stats stats() const;
+
+private:
+	[[nodiscard]] string path(const string& name, const char* ext) const;
+	[[nodiscard]] bool stale(const string& lease) const;
+	void heartbeat();
+
+	string m_dir;
+	double m_lease_seconds;
+	// host and process, written into leases and done markers
+	string m_owner;
+	mutable mutex m_mutex;
+	condition_variable m_wake;
+	set<string> m_held;
+	bool m_stop = false;
+	Stats m_stats;
+	thread m_heartbeat; // last, so it starts after everything it uses
+};